@@ -0,0 +1,309 @@
+#include "memory_manager/heap.h"
+#include "memory_manager/memory_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+*   Heap: push, top, pop  erase(index)  
+*   --min-size  --max-size (   10  10^8,
+*    10 ).    (int 
+* MemorySegmentIterator),      
+* : random -  , ascending -   
+*     ( push   ), adversarial -
+*    ( push   ).
+*
+*      ,  
+*  ,   ,   , 
+*       kLatencySamples  (
+*    ). 
+*  ,      kMinOperations.
+*  - JSON- ,    .   10^8
+*        .
+*
+* : heap_benchmark [--min-size=N] [--max-size=N] [--seed=N]
+*/
+
+constexpr size_t kMinOperations = 1000000;
+constexpr size_t kLatencySamples = 100000;
+
+using Clock = std::chrono::steady_clock;
+
+volatile size_t checksum_sink = 0;
+
+/*
+*  :     top()   .
+*/
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+enum class KeyOrder {
+    kRandom,
+    kAscending,
+    kAdversarial
+};
+
+const char* KeyOrderName(KeyOrder order) {
+    switch (order) {
+    case KeyOrder::kRandom:
+        return "random";
+    case KeyOrder::kAscending:
+        return "ascending";
+    case KeyOrder::kAdversarial:
+        return "adversarial";
+    }
+    return "unknown";
+}
+
+/*
+*     :  0    .
+*/
+std::vector<uint32_t> MakeRanks(size_t size, KeyOrder order, std::mt19937_64* random) {
+    std::vector<uint32_t> ranks(size);
+    std::iota(ranks.begin(), ranks.end(), 0);
+    if (order == KeyOrder::kRandom) {
+        std::shuffle(ranks.begin(), ranks.end(), *random);
+    } else if (order == KeyOrder::kAdversarial) {
+        std::reverse(ranks.begin(), ranks.end());
+    }
+    return ranks;
+}
+
+/*
+*   int:  ,   ,  
+*        .
+*/
+struct IntPayload {
+    using HeapType = DefaultHeap;
+
+    static constexpr const char* kName = "int";
+
+    std::vector<size_t> indices;
+    std::vector<int> values;
+
+    IntPayload(const std::vector<uint32_t>& ranks) :
+        indices(ranks.size(), HeapType::kNullIndex),
+        values(ranks.begin(), ranks.end()) {}
+
+    HeapType MakeHeap(bool observed) {
+        if (!observed) {
+            return HeapType();
+        }
+        return HeapType(std::less<int>(), [this](int value, size_t index) {
+            indices[value] = index;
+        });
+    }
+
+    int Value(size_t position) const {
+        return values[position];
+    }
+
+    static size_t Key(int value) {
+        return value;
+    }
+};
+
+/*
+*   MemorySegmentIterator:    
+* ,   MemoryManager,   MemorySegmentsHeapObserver.
+*    r   size - r.     0:
+*      ,     
+*    int.
+*/
+struct SegmentPayload {
+    using HeapType = MemorySegmentHeap;
+
+    static constexpr const char* kName = "iterator";
+
+    std::list<MemorySegment> segments;
+    std::vector<MemorySegmentIterator> values;
+
+    SegmentPayload(const std::vector<uint32_t>& ranks) {
+        values.reserve(ranks.size());
+        for (uint32_t rank : ranks) {
+            const int size = static_cast<int>(ranks.size() - rank);
+            segments.emplace_back(0, size - 1);
+            values.push_back(std::prev(segments.end()));
+        }
+    }
+
+    HeapType MakeHeap(bool observed) {
+        if (!observed) {
+            return HeapType();
+        }
+        return HeapType(MemorySegmentSizeCompare(), MemorySegmentsHeapObserver());
+    }
+
+    MemorySegmentIterator Value(size_t position) const {
+        return values[position];
+    }
+
+    static size_t Key(MemorySegmentIterator value) {
+        return value->Size();
+    }
+};
+
+struct OperationResult {
+    size_t operations = 0;
+    double seconds = 0;
+    std::vector<uint64_t> latencies;
+};
+
+template <class Operation>
+void TimeOperations(size_t count, bool sample, OperationResult* result, Operation operation) {
+    const size_t stride = std::max<size_t>(1, count / kLatencySamples);
+    if (!sample) {
+        const Clock::time_point start = Clock::now();
+        for (size_t step = 0; step < count; ++step) {
+            operation(step);
+        }
+        result->seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        result->operations += count;
+        return;
+    }
+    for (size_t step = 0; step < count; ++step) {
+        if (step % stride != 0) {
+            operation(step);
+            continue;
+        }
+        const Clock::time_point start = Clock::now();
+        operation(step);
+        result->latencies.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+}
+
+uint64_t Percentile(std::vector<uint64_t>* latencies, double share) {
+    if (latencies->empty()) {
+        return 0;
+    }
+    const size_t index = std::min(latencies->size() - 1,
+        static_cast<size_t>(share * latencies->size()));
+    std::nth_element(latencies->begin(), latencies->begin() + index, latencies->end());
+    return (*latencies)[index];
+}
+
+void PrintResult(const char* payload, bool observed, KeyOrder order, size_t size,
+    const char* operation, OperationResult* result, bool* first) {
+    const double ns_per_operation = result->operations == 0 ? 0 :
+        result->seconds * 1e9 / result->operations;
+    std::cout << (*first ? "\n" : ",\n")
+        << "  {\"payload\": \"" << payload << "\", \"observer\": " << (observed ? "true" : "false")
+        << ", \"order\": \"" << KeyOrderName(order) << "\", \"size\": " << size
+        << ", \"operation\": \"" << operation << "\", \"operations\": " << result->operations
+        << ", \"ns_per_operation\": " << ns_per_operation
+        << ", \"operations_per_second\": "
+        << (result->seconds == 0 ? 0 : result->operations / result->seconds)
+        << ", \"latency_ns\": {\"p50\": " << Percentile(&result->latencies, 0.5)
+        << ", \"p99\": " << Percentile(&result->latencies, 0.99)
+        << ", \"max\": " << Percentile(&result->latencies, 1.0) << "}}";
+    std::cout.flush();
+    *first = false;
+}
+
+/*
+*  : push  , top, erase   
+*    pop  .  sample  
+*  ,  -   .
+*/
+template <class Payload>
+void RunRound(Payload& payload, bool observed, bool sample, std::mt19937_64* random,
+    OperationResult* push, OperationResult* top, OperationResult* pop, OperationResult* erase) {
+    const size_t size = payload.values.size();
+    typename Payload::HeapType heap = payload.MakeHeap(observed);
+    TimeOperations(size, sample, push, [&](size_t step) {
+        heap.push(payload.Value(step));
+    });
+    size_t checksum = 0;
+    TimeOperations(size, sample, top, [&](size_t) {
+        checksum += Payload::Key(heap.top());
+        ClobberMemory();
+    });
+    TimeOperations(size, sample, pop, [&](size_t) {
+        heap.pop();
+    });
+
+    for (size_t position = 0; position < size; ++position) {
+        heap.push(payload.Value(position));
+    }
+    std::vector<size_t> erased_indices(size);
+    for (size_t step = 0; step < size; ++step) {
+        erased_indices[step] = (*random)() % (size - step);
+    }
+    TimeOperations(size, sample, erase, [&](size_t step) {
+        heap.erase(erased_indices[step]);
+    });
+    checksum_sink = checksum;
+}
+
+template <class Payload>
+void BenchmarkPayload(size_t size, bool observed, KeyOrder order, uint64_t seed, bool* first) {
+    std::mt19937_64 random(seed);
+    Payload payload(MakeRanks(size, order, &random));
+    OperationResult push;
+    OperationResult top;
+    OperationResult pop;
+    OperationResult erase;
+    const size_t rounds = std::max<size_t>(1, kMinOperations / size);
+    for (size_t round = 0; round < rounds; ++round) {
+        RunRound(payload, observed, false, &random, &push, &top, &pop, &erase);
+    }
+    RunRound(payload, observed, true, &random, &push, &top, &pop, &erase);
+    PrintResult(Payload::kName, observed, order, size, "push", &push, first);
+    PrintResult(Payload::kName, observed, order, size, "top", &top, first);
+    PrintResult(Payload::kName, observed, order, size, "pop", &pop, first);
+    PrintResult(Payload::kName, observed, order, size, "erase", &erase, first);
+}
+
+int main(int argc, char** argv) {
+    size_t min_size = 10;
+    size_t max_size = 100000000;
+    uint64_t seed = 1;
+    try {
+        for (int current_argument = 1; current_argument < argc; ++current_argument) {
+            const std::string argument = argv[current_argument];
+            if (argument.compare(0, 11, "--min-size=") == 0) {
+                min_size = std::stoull(argument.substr(11));
+            } else if (argument.compare(0, 11, "--max-size=") == 0) {
+                max_size = std::stoull(argument.substr(11));
+            } else if (argument.compare(0, 7, "--seed=") == 0) {
+                seed = std::stoull(argument.substr(7));
+            } else {
+                throw std::invalid_argument("Unknown option: " + argument);
+            }
+        }
+        if (min_size == 0 || max_size > INT_MAX) {
+            throw std::invalid_argument("Heap sizes must be in [1, 2^31)");
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n"
+            << "Usage: heap_benchmark [--min-size=N] [--max-size=N] [--seed=N]\n";
+        return 1;
+    }
+
+    bool first = true;
+    std::cout << "[";
+    for (size_t size = min_size; size <= max_size; size *= 10) {
+        for (KeyOrder order : { KeyOrder::kRandom, KeyOrder::kAscending, KeyOrder::kAdversarial }) {
+            for (bool observed : { false, true }) {
+                BenchmarkPayload<IntPayload>(size, observed, order, seed, &first);
+                BenchmarkPayload<SegmentPayload>(size, observed, order, seed, &first);
+            }
+        }
+        if (size > max_size / 10) {
+            break;
+        }
+    }
+    std::cout << "\n]\n";
+    return 0;
+}
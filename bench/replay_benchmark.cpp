@@ -0,0 +1,89 @@
+#include "memory_manager/replay.h"
+#include "memory_manager/trace_io.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+*    trace'       
+*  : trace   ,    repetitions
+* .    (trace, )   TSV   
+*  .
+*
+* : replay_benchmark [--repetitions=N] TRACE...
+*/
+
+struct LoadedTrace {
+    std::string path;
+    size_t memory_size;
+    std::vector<MemoryManagerQuery> queries;
+};
+
+LoadedTrace LoadTrace(const std::string& path) {
+    MappedFile trace(path);
+    LoadedTrace loaded{ path, 0, {} };
+    if (IsBinaryTrace(trace.begin(), trace.end())) {
+        BinaryTraceReader trace_reader(trace.begin(), trace.end());
+        loaded.memory_size = trace_reader.MemorySize();
+        loaded.queries = ReadTraceQueries(trace_reader);
+    } else {
+        FastInputReader input_reader(trace.begin(), trace.end());
+        TextTraceReader trace_reader(input_reader);
+        loaded.memory_size = trace_reader.MemorySize();
+        loaded.queries = ReadTraceQueries(trace_reader);
+    }
+    return loaded;
+}
+
+int main(int argc, char** argv) {
+    size_t repetitions = 5;
+    std::vector<std::string> paths;
+    for (int current_argument = 1; current_argument < argc; ++current_argument) {
+        const std::string argument = argv[current_argument];
+        if (argument.compare(0, 14, "--repetitions=") == 0) {
+            repetitions = std::max<size_t>(std::stoul(argument.substr(14)), 1);
+        } else {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: replay_benchmark [--repetitions=N] TRACE...\n";
+        return 1;
+    }
+
+    const std::pair<const char*, MemoryManagerEngine> engines[] = {
+        { "list", MemoryManagerEngine::kSegmentList },
+        { "bitmap", MemoryManagerEngine::kBitmap },
+        { "slab", MemoryManagerEngine::kSlab },
+    };
+    std::cout << "trace\tengine\tqueries\tbest_seconds\tmean_seconds\n";
+    try {
+        for (const std::string& path : paths) {
+            const LoadedTrace trace = LoadTrace(path);
+            for (const auto& engine : engines) {
+                ReplayOptions options;
+                options.engine = engine.second;
+                double best = 0;
+                double total = 0;
+                for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+                    const auto start = std::chrono::steady_clock::now();
+                    const std::vector<MemoryManagerAllocationResponse> responses =
+                        RunMemoryManager(trace.memory_size, trace.queries, options);
+                    const double seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+                    best = repetition == 0 ? seconds : std::min(best, seconds);
+                    total += seconds;
+                }
+                std::cout << trace.path << "\t" << engine.first << "\t" << trace.queries.size()
+                    << "\t" << best << "\t" << total / repetitions << "\n";
+            }
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
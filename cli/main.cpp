@@ -0,0 +1,164 @@
+#include "memory_manager/daemon.h"
+#include "memory_manager/replay.h"
+#include "memory_manager/trace_io.h"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+*      "id:soft:hard:reservation".
+*       .
+*/
+std::pair<TenantId, TenantLimits> ParseTenantLimits(const std::string& description) {
+    std::istringstream fields(description);
+    std::string field;
+    std::vector<std::string> values;
+    while (std::getline(fields, field, ':')) {
+        values.push_back(field);
+    }
+    if (values.empty() || values[0].empty() || values.size() > 4) {
+        throw std::invalid_argument("Invalid tenant limits: " + description);
+    }
+    values.resize(4);
+    TenantLimits limits;
+    if (!values[1].empty()) {
+        limits.soft_quota = std::stoul(values[1]);
+    }
+    if (!values[2].empty()) {
+        limits.hard_quota = std::stoul(values[2]);
+    }
+    if (!values[3].empty()) {
+        limits.reservation = std::stoul(values[3]);
+    }
+    return std::make_pair(static_cast<TenantId>(std::stoul(values[0])), limits);
+}
+
+ReplayOptions ParseReplayOptions(int argc, char** argv) {
+    ReplayOptions options;
+    for (int current_argument = 1; current_argument < argc; ++current_argument) {
+        const std::string argument = argv[current_argument];
+        if (argument == "--engine=list") {
+            options.engine = MemoryManagerEngine::kSegmentList;
+        } else if (argument == "--engine=bitmap") {
+            options.engine = MemoryManagerEngine::kBitmap;
+        } else if (argument == "--policy=largest-first") {
+            options.policy = AllocationPolicy::kLargestFirst;
+        } else if (argument == "--policy=next-fit") {
+            options.policy = AllocationPolicy::kNextFit;
+        } else if (argument == "--engine=slab") {
+            options.engine = MemoryManagerEngine::kSlab;
+        } else if (argument.compare(0, 9, "--tenant=") == 0) {
+            options.tenant_limits.push_back(ParseTenantLimits(argument.substr(9)));
+        } else if (argument.compare(0, 12, "--hot-sizes=") == 0) {
+            std::istringstream sizes(argument.substr(12));
+            std::string size;
+            while (std::getline(sizes, size, ',')) {
+                options.hot_sizes.push_back(std::stoul(size));
+            }
+        } else if (argument.compare(0, 12, "--to-binary=") == 0) {
+            options.convert_format = TraceFormat::kBinary;
+            options.convert_path = argument.substr(12);
+        } else if (argument.compare(0, 10, "--to-text=") == 0) {
+            options.convert_format = TraceFormat::kText;
+            options.convert_path = argument.substr(10);
+        } else if (argument.compare(0, 8, "--batch=") == 0) {
+            options.batch_path = argument.substr(8);
+        } else if (argument.compare(0, 13, "--output-dir=") == 0) {
+            options.output_dir = argument.substr(13);
+        } else if (argument.compare(0, 10, "--threads=") == 0) {
+            //  --batch     trace',  
+            //   trace'  .
+            options.threads_count = std::stoul(argument.substr(10));
+        } else if (argument.compare(0, 9, "--daemon=") == 0) {
+            options.daemon_socket = argument.substr(9);
+        } else if (argument.compare(0, 12, "--load-test=") == 0) {
+            options.load_test_socket = argument.substr(12);
+        } else if (argument.compare(0, 14, "--memory-size=") == 0) {
+            options.memory_size = std::stoul(argument.substr(14));
+        } else if (argument.compare(0, 10, "--clients=") == 0) {
+            options.load_clients = std::stoul(argument.substr(10));
+        } else if (argument.compare(0, 11, "--requests=") == 0) {
+            options.load_requests = std::stoul(argument.substr(11));
+        } else if (argument.compare(0, 11, "--max-size=") == 0) {
+            options.load_max_size = std::stoul(argument.substr(11));
+        } else if (argument == "--transport=socket") {
+            options.shared_memory = false;
+        } else if (argument == "--transport=shm") {
+            options.shared_memory = true;
+        } else if (argument == "--io-uring") {
+            options.io_uring = true;
+        } else if (argument == "--pipeline") {
+            options.pipeline = true;
+        } else if (argument == "--stream") {
+            options.stream = true;
+        } else if (argument.compare(0, 2, "--") != 0 && options.trace_path.empty()) {
+            options.trace_path = argument;
+        } else {
+            throw std::invalid_argument("Unknown option: " + argument);
+        }
+    }
+    if (!options.daemon_socket.empty() && options.memory_size == 0) {
+        throw std::invalid_argument("--daemon requires --memory-size");
+    }
+    if (options.load_clients == 0 || options.load_max_size == 0) {
+        throw std::invalid_argument("--clients and --max-size must be positive");
+    }
+    //   trace     , 
+    //     .
+    if (options.convert_format != TraceFormat::kNone && (options.stream || options.pipeline)) {
+        throw std::invalid_argument(
+            "--to-binary and --to-text cannot be combined with --stream or --pipeline");
+    }
+    return options;
+}
+
+int main(int argc, char** argv) {
+
+    ReplayOptions options;
+    try {
+        options = ParseReplayOptions(argc, argv);
+    } catch (const std::invalid_argument& error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    try {
+        if (!options.batch_path.empty()) {
+            return RunBatchReplay(options) ? 0 : 1;
+        }
+        if (!options.daemon_socket.empty() && options.shared_memory) {
+            SharedMemoryAllocatorServer server(options.memory_size, options);
+            server.Serve(options.daemon_socket);
+            return 0;
+        }
+        if (!options.daemon_socket.empty()) {
+            AllocatorDaemon daemon(options.memory_size, options);
+            daemon.Serve(options.daemon_socket);
+            return 0;
+        }
+        if (!options.load_test_socket.empty() && options.shared_memory) {
+            RunDaemonLoadTest<SharedMemoryClient>(options, std::cout);
+            return 0;
+        }
+        if (!options.load_test_socket.empty()) {
+            RunDaemonLoadTest<DaemonClient>(options, std::cout);
+            return 0;
+        }
+        if (options.io_uring) {
+            ReplayWithAsyncIo(options);
+        } else if (options.trace_path.empty()) {
+            FastInputReader input_reader(stdin);
+            ReplayTraceStream(input_reader, std::cout, options);
+        } else {
+            ReplayTraceFile(options.trace_path, std::cout, options);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define MEMORY_MANAGER_HAS_IO_URING 1
+#endif
+
+/*
+*    io_uring   ,  liburing:
+*         , 
+*          io_uring_enter.
+*   ( )   io_uring, Create 
+* nullptr,       read/write.
+*/
+
+class IoUring {
+public:
+    struct Completion {
+        uint64_t user_data;
+        int32_t result;
+    };
+
+    static std::unique_ptr<IoUring> Create(unsigned entries) {
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+        std::unique_ptr<IoUring> ring(new IoUring());
+        if (ring->Setup(entries)) {
+            return ring;
+        }
+#endif
+        (void)entries;
+        return nullptr;
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    void SubmitRead(int fd, char* data, size_t size, uint64_t offset, uint64_t user_data) {
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+        Submit(IORING_OP_READ, fd, data, size, offset, user_data);
+#endif
+    }
+
+    void SubmitWrite(int fd, const char* data, size_t size, uint64_t offset, uint64_t user_data) {
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+        Submit(IORING_OP_WRITE, fd, const_cast<char*>(data), size, offset, user_data);
+#endif
+    }
+
+    //     .
+    Completion WaitCompletion() {
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+        while (true) {
+            const unsigned head = Load(cq_head_, std::memory_order_relaxed);
+            if (head != Load(cq_tail_, std::memory_order_acquire)) {
+                const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+                const Completion completion{ cqe.user_data, cqe.res };
+                Store(cq_head_, head + 1);
+                return completion;
+            }
+            if (::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                throw std::runtime_error("io_uring_enter failed");
+            }
+        }
+#else
+        throw std::logic_error("io_uring is not available");
+#endif
+    }
+
+private:
+#ifdef MEMORY_MANAGER_HAS_IO_URING
+    int fd_ = -1;
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    void* sqes_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+
+    IoUring() = default;
+
+    static unsigned Load(unsigned* value, std::memory_order order) {
+        return std::atomic_ref<unsigned>(*value).load(order);
+    }
+
+    static void Store(unsigned* value, unsigned new_value) {
+        std::atomic_ref<unsigned>(*value).store(new_value, std::memory_order_release);
+    }
+
+    bool Setup(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        // IORING_OP_READ  IORING_OP_WRITE    IORING_FEAT_RW_CUR_POS.
+        if (fd_ < 0 || (params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+            return false;
+        }
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        cq_ring_ = single_mmap ? sq_ring_ : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+        char* sq_ring = static_cast<char*>(sq_ring_);
+        char* cq_ring = static_cast<char*>(cq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+        return true;
+    }
+
+    //        ,  entries.
+    void Submit(uint8_t opcode, int fd, char* data, size_t size, uint64_t offset,
+        uint64_t user_data) {
+        const unsigned tail = Load(sq_tail_, std::memory_order_relaxed);
+        const unsigned index = tail & *sq_mask_;
+        io_uring_sqe& sqe = static_cast<io_uring_sqe*>(sqes_)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(data);
+        sqe.len = static_cast<uint32_t>(size);
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array_[index] = index;
+        Store(sq_tail_, tail + 1);
+        while (::syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw std::runtime_error("io_uring_enter failed");
+            }
+        }
+    }
+#endif
+};
+
+/*
+*    :  io_uring     depth
+*   chunk_size    ,  Read 
+*     ,     
+*   .     (, ) 
+*   io_uring   read.
+*/
+
+class AsyncFileReader {
+public:
+    explicit AsyncFileReader(int fd, size_t chunk_size = 1 << 20, size_t depth = 4) :
+        fd_(fd),
+        next_offset_(0),
+        file_size_(0),
+        consumed_chunk_(0),
+        consumed_bytes_(0) {
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+            return;
+        }
+        const off_t offset = ::lseek(fd, 0, SEEK_CUR);
+        if (offset < 0) {
+            return;
+        }
+        ring_ = IoUring::Create(static_cast<unsigned>(depth));
+        if (!ring_) {
+            return;
+        }
+        next_offset_ = offset;
+        file_size_ = file_stat.st_size;
+        chunks_.resize(depth);
+        for (size_t chunk = 0; chunk < depth; ++chunk) {
+            chunks_[chunk].data.resize(chunk_size);
+            SubmitChunk(chunk);
+        }
+    }
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    ~AsyncFileReader() {
+        //   ,      .
+        try {
+            for (const Chunk& chunk : chunks_) {
+                while (chunk.in_flight) {
+                    Complete(ring_->WaitCompletion());
+                }
+            }
+        } catch (...) {
+        }
+        if (ring_) {
+            ::lseek(fd_, next_offset_, SEEK_SET);
+        }
+    }
+
+    //    size ;  0   .
+    size_t Read(char* data, size_t size) {
+        if (!ring_) {
+            while (true) {
+                const ssize_t read = ::read(fd_, data, size);
+                if (read >= 0) {
+                    return read;
+                }
+                if (errno != EINTR) {
+                    throw std::runtime_error("Cannot read input");
+                }
+            }
+        }
+        Chunk& chunk = chunks_[consumed_chunk_];
+        while (chunk.in_flight) {
+            Complete(ring_->WaitCompletion());
+        }
+        const size_t read = std::min(size, chunk.filled - consumed_bytes_);
+        std::memcpy(data, chunk.data.data() + consumed_bytes_, read);
+        consumed_bytes_ += read;
+        if (consumed_bytes_ == chunk.filled && chunk.filled != 0) {
+            SubmitChunk(consumed_chunk_);
+            consumed_chunk_ = (consumed_chunk_ + 1) % chunks_.size();
+            consumed_bytes_ = 0;
+        }
+        return read;
+    }
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t filled = 0;
+        bool in_flight = false;
+    };
+
+    int fd_;
+    std::unique_ptr<IoUring> ring_;
+    std::vector<Chunk> chunks_;
+    uint64_t next_offset_;
+    uint64_t file_size_;
+    size_t consumed_chunk_;
+    size_t consumed_bytes_;
+
+    void SubmitChunk(size_t index) {
+        Chunk& chunk = chunks_[index];
+        chunk.offset = next_offset_;
+        chunk.length = std::min<uint64_t>(chunk.data.size(), file_size_ - std::min(file_size_, next_offset_));
+        chunk.filled = 0;
+        next_offset_ += chunk.length;
+        if (chunk.length != 0) {
+            chunk.in_flight = true;
+            SubmitRemainder(index);
+        }
+    }
+
+    void SubmitRemainder(size_t index) {
+        Chunk& chunk = chunks_[index];
+        ring_->SubmitRead(fd_, chunk.data.data() + chunk.filled, chunk.length - chunk.filled,
+            chunk.offset + chunk.filled, index);
+    }
+
+    void Complete(const IoUring::Completion& completion) {
+        Chunk& chunk = chunks_[completion.user_data];
+        if (completion.result == -EINTR || completion.result == -EAGAIN) {
+            SubmitRemainder(completion.user_data);
+            return;
+        }
+        if (completion.result < 0) {
+            chunk.in_flight = false;
+            throw std::runtime_error("Cannot read input");
+        }
+        chunk.filled += completion.result;
+        if (completion.result == 0) {
+            //     .
+            chunk.length = chunk.filled;
+            file_size_ = chunk.offset + chunk.filled;
+        }
+        if (chunk.filled < chunk.length) {
+            SubmitRemainder(completion.user_data);
+        } else {
+            chunk.in_flight = false;
+        }
+    }
+};
+
+/*
+*   ,     chunk_size 
+*     io_uring:     depth ,
+*    .       
+* ;  ,     io_uring 
+*   write.     Finish,  
+*   std::ostream -     badbit.
+*/
+
+class AsyncFileWriter : public std::streambuf {
+public:
+    explicit AsyncFileWriter(int fd, size_t chunk_size = 1 << 20, size_t depth = 4) :
+        fd_(fd),
+        next_offset_(0),
+        current_chunk_(0),
+        failed_(false) {
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+            (::fcntl(fd, F_GETFL) & O_APPEND) == 0) {
+            const off_t offset = ::lseek(fd, 0, SEEK_CUR);
+            if (offset >= 0) {
+                ring_ = IoUring::Create(static_cast<unsigned>(depth));
+                next_offset_ = offset;
+            }
+        }
+        chunks_.resize(ring_ ? depth : 1);
+        for (Chunk& chunk : chunks_) {
+            chunk.data.resize(chunk_size);
+        }
+        ResetPutArea();
+    }
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    ~AsyncFileWriter() {
+        try {
+            Finish();
+        } catch (...) {
+        }
+    }
+
+    //        .
+    void Finish() {
+        SubmitCurrentChunk();
+        for (size_t chunk = 0; chunk < chunks_.size(); ++chunk) {
+            WaitChunk(chunk);
+        }
+        if (ring_) {
+            ::lseek(fd_, next_offset_, SEEK_SET);
+        }
+        if (failed_) {
+            throw std::runtime_error("Cannot write output");
+        }
+    }
+
+protected:
+    int_type overflow(int_type character) override {
+        if (!SubmitCurrentChunkSafely()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(character, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(character);
+            pbump(1);
+        }
+        return traits_type::not_eof(character);
+    }
+
+    int sync() override {
+        return failed_ ? -1 : 0;
+    }
+
+private:
+    struct Chunk {
+        std::vector<char> data;
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t written = 0;
+        bool in_flight = false;
+    };
+
+    int fd_;
+    std::unique_ptr<IoUring> ring_;
+    std::vector<Chunk> chunks_;
+    uint64_t next_offset_;
+    size_t current_chunk_;
+    bool failed_;
+
+    void ResetPutArea() {
+        char* data = chunks_[current_chunk_].data.data();
+        setp(data, data + chunks_[current_chunk_].data.size());
+    }
+
+    bool SubmitCurrentChunkSafely() {
+        try {
+            SubmitCurrentChunk();
+        } catch (const std::runtime_error&) {
+            failed_ = true;
+        }
+        return !failed_;
+    }
+
+    void SubmitCurrentChunk() {
+        Chunk& chunk = chunks_[current_chunk_];
+        chunk.length = pptr() - pbase();
+        chunk.written = 0;
+        if (chunk.length == 0) {
+            return;
+        }
+        if (!ring_) {
+            while (chunk.written < chunk.length) {
+                const ssize_t written = ::write(fd_, chunk.data.data() + chunk.written,
+                    chunk.length - chunk.written);
+                if (written < 0 && errno != EINTR) {
+                    failed_ = true;
+                    throw std::runtime_error("Cannot write output");
+                }
+                chunk.written += std::max<ssize_t>(written, 0);
+            }
+            ResetPutArea();
+            return;
+        }
+        chunk.offset = next_offset_;
+        next_offset_ += chunk.length;
+        chunk.in_flight = true;
+        SubmitRemainder(current_chunk_);
+        current_chunk_ = (current_chunk_ + 1) % chunks_.size();
+        WaitChunk(current_chunk_);
+        ResetPutArea();
+    }
+
+    void SubmitRemainder(size_t index) {
+        Chunk& chunk = chunks_[index];
+        ring_->SubmitWrite(fd_, chunk.data.data() + chunk.written, chunk.length - chunk.written,
+            chunk.offset + chunk.written, index);
+    }
+
+    void WaitChunk(size_t index) {
+        while (chunks_[index].in_flight) {
+            const IoUring::Completion completion = ring_->WaitCompletion();
+            Chunk& chunk = chunks_[completion.user_data];
+            if (completion.result == -EINTR || completion.result == -EAGAIN) {
+                SubmitRemainder(completion.user_data);
+                continue;
+            }
+            if (completion.result <= 0) {
+                chunk.in_flight = false;
+                failed_ = true;
+                continue;
+            }
+            chunk.written += completion.result;
+            if (chunk.written < chunk.length) {
+                SubmitRemainder(completion.user_data);
+            } else {
+                chunk.in_flight = false;
+            }
+        }
+    }
+};
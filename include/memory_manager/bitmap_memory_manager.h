@@ -0,0 +1,183 @@
+#pragma once
+
+#include "memory_manager/memory_manager.h"
+#include "memory_manager/radix_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/*
+*      :  
+*     (1 -  ).   
+*    ,     
+*  ,      . 
+*          ,
+*    k   O(k / 64 + log n)  - 
+*       .  
+*    radix-   .
+*/
+
+class BitmapMemoryManager {
+public:
+    static constexpr size_t kNullPosition = 0;
+
+    explicit BitmapMemoryManager(size_t memory_size) :
+        memory_size_(memory_size) {
+        if (memory_size >= (static_cast<size_t>(1) << 32)) {
+            throw std::invalid_argument("BitmapMemoryManager memory size is too large");
+        }
+        const size_t words_count = (memory_size + kWordBits - 1) / kWordBits;
+        words_.assign(words_count, ~Word(0));
+        if (memory_size % kWordBits != 0) {
+            words_.back() = (Word(1) << (memory_size % kWordBits)) - 1;
+        }
+        leaves_count_ = 1;
+        while (leaves_count_ < words_count) {
+            leaves_count_ *= 2;
+        }
+        summaries_.assign(2 * leaves_count_, Summary());
+        for (size_t word = 0; word < words_count; ++word) {
+            summaries_[leaves_count_ + word] = MakeLeafSummary(word);
+        }
+        for (size_t node = leaves_count_ - 1; node > 0; --node) {
+            summaries_[node] = Merge(summaries_[2 * node], summaries_[2 * node + 1]);
+        }
+    }
+
+    size_t Allocate(size_t size) {
+        const Summary& root = summaries_[1];
+        if (size == 0 || root.best < size) {
+            return kNullPosition;
+        }
+        const size_t first_unit = root.best_start;
+        SetUnits(first_unit, first_unit + size, false);
+        allocation_sizes_.Insert(first_unit + 1, size);
+        return first_unit + 1;
+    }
+
+    void Free(size_t position) {
+        const size_t* size = allocation_sizes_.Find(position);
+        if (size == nullptr) {
+            return;
+        }
+        SetUnits(position - 1, position - 1 + *size, true);
+        allocation_sizes_.Erase(position);
+    }
+
+    size_t MaxFreeSize() const {
+        return summaries_[1].best;
+    }
+
+private:
+    using Word = uint64_t;
+    static constexpr size_t kWordBits = 64;
+
+    struct Summary {
+        uint32_t start = 0;
+        uint32_t length = 0;
+        uint32_t prefix = 0;
+        uint32_t suffix = 0;
+        uint32_t best = 0;
+        uint32_t best_start = 0;
+    };
+
+    size_t memory_size_;
+    size_t leaves_count_;
+    std::vector<Word> words_;
+    std::vector<Summary> summaries_;
+    RadixTree<size_t> allocation_sizes_;
+
+    static uint32_t TrailingOnes(Word word) {
+        return word == ~Word(0) ? kWordBits : __builtin_ctzll(~word);
+    }
+
+    static uint32_t LeadingOnes(Word word) {
+        return word == ~Word(0) ? kWordBits : __builtin_clzll(~word);
+    }
+
+    static Word RangeMask(size_t from, size_t to) {
+        if (to - from == kWordBits) {
+            return ~Word(0);
+        }
+        return ((Word(1) << (to - from)) - 1) << from;
+    }
+
+    Summary MakeLeafSummary(size_t word_index) const {
+        const Word word = words_[word_index];
+        Summary summary;
+        summary.start = word_index * kWordBits;
+        summary.length = std::min(kWordBits, memory_size_ - word_index * kWordBits);
+        summary.prefix = TrailingOnes(word);
+        summary.suffix = std::min<uint32_t>(
+            LeadingOnes(word << (kWordBits - summary.length)), summary.length);
+        uint32_t offset = 0;
+        Word rest = word;
+        while (rest != 0) {
+            const uint32_t skip = __builtin_ctzll(rest);
+            rest >>= skip;
+            offset += skip;
+            const uint32_t run = TrailingOnes(rest);
+            if (run > summary.best) {
+                summary.best = run;
+                summary.best_start = summary.start + offset;
+            }
+            if (run == kWordBits) {
+                break;
+            }
+            rest >>= run;
+            offset += run;
+        }
+        return summary;
+    }
+
+    static Summary Merge(const Summary& left, const Summary& right) {
+        if (right.length == 0) {
+            return left;
+        }
+        Summary summary;
+        summary.start = left.start;
+        summary.length = left.length + right.length;
+        summary.prefix = left.prefix == left.length ?
+            left.length + right.prefix : left.prefix;
+        summary.suffix = right.suffix == right.length ?
+            right.length + left.suffix : right.suffix;
+        summary.best = left.best;
+        summary.best_start = left.best_start;
+        if (left.suffix + right.prefix > summary.best) {
+            summary.best = left.suffix + right.prefix;
+            summary.best_start = left.start + left.length - left.suffix;
+        }
+        if (right.best > summary.best) {
+            summary.best = right.best;
+            summary.best_start = right.best_start;
+        }
+        return summary;
+    }
+
+    void SetUnits(size_t first_unit, size_t last_unit, bool free) {
+        const size_t first_word = first_unit / kWordBits;
+        const size_t last_word = (last_unit - 1) / kWordBits;
+        for (size_t word = first_word; word <= last_word; ++word) {
+            const size_t from = std::max(first_unit, word * kWordBits) - word * kWordBits;
+            const size_t to = std::min(last_unit, (word + 1) * kWordBits) - word * kWordBits;
+            if (free) {
+                words_[word] |= RangeMask(from, to);
+            } else {
+                words_[word] &= ~RangeMask(from, to);
+            }
+            summaries_[leaves_count_ + word] = MakeLeafSummary(word);
+        }
+        size_t first_node = leaves_count_ + first_word;
+        size_t last_node = leaves_count_ + last_word;
+        while (first_node > 1) {
+            first_node /= 2;
+            last_node /= 2;
+            for (size_t node = first_node; node <= last_node; ++node) {
+                summaries_[node] = Merge(summaries_[2 * node], summaries_[2 * node + 1]);
+            }
+        }
+    }
+};
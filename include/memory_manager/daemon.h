@@ -0,0 +1,792 @@
+#pragma once
+
+#include "memory_manager/memory_manager.h"
+#include "memory_manager/replay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+*  :    Unix-  DaemonRequest
+*  ,        
+* DaemonResponse    .      ,
+*         .  kAllocate value -
+*  ,   - ;  kFree value - 
+*  ;  kStats   value -  , 
+* extra -   .
+*/
+
+enum class DaemonRequestType : uint8_t {
+    kAllocate = 1,
+    kFree = 2,
+    kStats = 3
+};
+
+enum class DaemonStatus : uint8_t {
+    kOk = 0,
+    kFailed = 1,
+    kInvalidRequest = 2
+};
+
+struct DaemonRequest {
+    DaemonRequestType type;
+    uint8_t reserved[3];
+    TenantId tenant;
+    uint64_t value;
+};
+
+struct DaemonResponse {
+    DaemonStatus status;
+    uint8_t reserved[7];
+    uint64_t value;
+    uint64_t extra;
+};
+
+static_assert(sizeof(DaemonRequest) == 16, "DaemonRequest must be packed");
+static_assert(sizeof(DaemonResponse) == 24, "DaemonResponse must be packed");
+
+//   SIGINT  SIGTERM,  StopDaemonOnSignals.
+extern volatile std::sig_atomic_t daemon_stop_requested;
+
+void StopDaemonOnSignals();
+
+/*
+*       MemoryManager;  
+*   .
+*/
+
+class AllocatorService {
+public:
+    AllocatorService(size_t memory_size, const ReplayOptions& options) :
+        memory_(memory_size, options.policy),
+        used_memory_(0),
+        live_allocations_(0) {
+        for (const auto& tenant_limits : options.tenant_limits) {
+            memory_.SetTenantLimits(tenant_limits.first, tenant_limits.second);
+        }
+    }
+
+    /*
+    *        ,    
+    *         
+    *  .
+    */
+    DaemonResponse Execute(const DaemonRequest& request) {
+        DaemonResponse response;
+        std::memset(&response, 0, sizeof(response));
+        if (request.tenant >= TenantQuotas::kMaxTenants) {
+            response.status = DaemonStatus::kInvalidRequest;
+            return response;
+        }
+        try {
+            ExecuteValid(request, &response);
+        } catch (const std::exception&) {
+            std::memset(&response, 0, sizeof(response));
+            response.status = DaemonStatus::kFailed;
+        }
+        return response;
+    }
+
+private:
+    MemoryManager memory_;
+    size_t used_memory_;
+    size_t live_allocations_;
+
+    void ExecuteValid(const DaemonRequest& request, DaemonResponse* response) {
+        response->status = DaemonStatus::kOk;
+        switch (request.type) {
+        case DaemonRequestType::kAllocate: {
+            MemoryManager::Iterator segment = request.value == 0 ? memory_.end() :
+                memory_.Allocate(request.value, request.tenant);
+            if (segment == memory_.end()) {
+                response->status = DaemonStatus::kFailed;
+            } else {
+                used_memory_ += segment->Size();
+                ++live_allocations_;
+                response->value = segment->left;
+            }
+            break;
+        }
+        case DaemonRequestType::kFree: {
+            MemoryManager::Iterator segment = memory_.Find(request.value);
+            if (segment == memory_.end()) {
+                response->status = DaemonStatus::kInvalidRequest;
+            } else {
+                used_memory_ -= segment->Size();
+                --live_allocations_;
+                memory_.Free(segment);
+            }
+            break;
+        }
+        case DaemonRequestType::kStats:
+            response->value = used_memory_;
+            response->extra = live_allocations_;
+            break;
+        default:
+            response->status = DaemonStatus::kInvalidRequest;
+        }
+    }
+};
+
+/*
+* ,   MemoryManager   .   epoll
+*           
+*  ,         
+*  ,        
+*  .   SIGINT  SIGTERM.
+*/
+
+class AllocatorDaemon {
+public:
+    AllocatorDaemon(size_t memory_size, const ReplayOptions& options) :
+        service_(memory_size, options),
+        next_client_id_(kListenerId + 1) {}
+
+    void Serve(const std::string& socket_path) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path is too long: " + socket_path);
+        }
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+        listener_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener_ < 0) {
+            throw std::runtime_error("Cannot create socket");
+        }
+        ::unlink(socket_path.c_str());
+        if (::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listener_, SOMAXCONN) != 0) {
+            ::close(listener_);
+            throw std::runtime_error("Cannot listen on " + socket_path);
+        }
+        epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_ < 0) {
+            ::close(listener_);
+            throw std::runtime_error("Cannot create epoll instance");
+        }
+        Watch(listener_, kListenerId, EPOLLIN, EPOLL_CTL_ADD);
+        StopDaemonOnSignals();
+
+        std::vector<epoll_event> events(256);
+        while (!daemon_stop_requested) {
+            const int ready = ::epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            batch_.clear();
+            for (int event = 0; event < ready; ++event) {
+                const uint64_t client_id = events[event].data.u64;
+                if (client_id == kListenerId) {
+                    AcceptClients();
+                    continue;
+                }
+                if (events[event].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    ReadRequests(client_id);
+                }
+                if (events[event].events & EPOLLOUT) {
+                    SendResponses(client_id);
+                }
+            }
+            ExecuteBatch();
+        }
+
+        for (const auto& client : clients_) {
+            ::close(client.second.fd);
+        }
+        clients_.clear();
+        ::close(epoll_);
+        ::close(listener_);
+        ::unlink(socket_path.c_str());
+    }
+
+private:
+    static constexpr uint64_t kListenerId = 0;
+
+    struct Client {
+        int fd;
+        std::string input;
+        std::string output;
+        size_t output_sent = 0;
+        bool waiting_output = false;
+    };
+
+    struct PendingRequest {
+        uint64_t client_id;
+        DaemonRequest request;
+    };
+
+    AllocatorService service_;
+    int listener_ = -1;
+    int epoll_ = -1;
+    uint64_t next_client_id_;
+    std::unordered_map<uint64_t, Client> clients_;
+    std::vector<PendingRequest> batch_;
+
+    void Watch(int fd, uint64_t id, uint32_t events, int operation) {
+        epoll_event event;
+        event.events = events;
+        event.data.u64 = id;
+        ::epoll_ctl(epoll_, operation, fd, &event);
+    }
+
+    void AcceptClients() {
+        while (true) {
+            const int fd = ::accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            const uint64_t client_id = next_client_id_++;
+            clients_[client_id].fd = fd;
+            Watch(fd, client_id, EPOLLIN, EPOLL_CTL_ADD);
+        }
+    }
+
+    void CloseClient(uint64_t client_id) {
+        auto client = clients_.find(client_id);
+        if (client != clients_.end()) {
+            ::close(client->second.fd);
+            clients_.erase(client);
+        }
+    }
+
+    void ReadRequests(uint64_t client_id) {
+        auto found = clients_.find(client_id);
+        if (found == clients_.end()) {
+            return;
+        }
+        Client& client = found->second;
+        char buffer[1 << 16];
+        bool closed = false;
+        while (true) {
+            const ssize_t received = ::recv(client.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                client.input.append(buffer, received);
+                continue;
+            }
+            closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+            if (closed || errno != EINTR) {
+                break;
+            }
+        }
+        size_t parsed = 0;
+        while (client.input.size() - parsed >= sizeof(DaemonRequest)) {
+            PendingRequest pending{ client_id, {} };
+            std::memcpy(&pending.request, client.input.data() + parsed, sizeof(DaemonRequest));
+            batch_.push_back(pending);
+            parsed += sizeof(DaemonRequest);
+        }
+        client.input.erase(0, parsed);
+        //      ,  .
+        if (closed) {
+            CloseClient(client_id);
+        }
+    }
+
+    void ExecuteBatch() {
+        for (const PendingRequest& pending : batch_) {
+            const DaemonResponse response = service_.Execute(pending.request);
+            auto client = clients_.find(pending.client_id);
+            if (client != clients_.end()) {
+                client->second.output.append(reinterpret_cast<const char*>(&response), sizeof(response));
+            }
+        }
+        for (const PendingRequest& pending : batch_) {
+            auto client = clients_.find(pending.client_id);
+            if (client != clients_.end() && !client->second.waiting_output &&
+                client->second.output.size() != client->second.output_sent) {
+                SendResponses(pending.client_id);
+            }
+        }
+    }
+
+    void SendResponses(uint64_t client_id) {
+        auto found = clients_.find(client_id);
+        if (found == clients_.end()) {
+            return;
+        }
+        Client& client = found->second;
+        while (client.output_sent < client.output.size()) {
+            const ssize_t sent = ::send(client.fd, client.output.data() + client.output_sent,
+                client.output.size() - client.output_sent, MSG_NOSIGNAL);
+            if (sent >= 0) {
+                client.output_sent += sent;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                CloseClient(client_id);
+                return;
+            }
+        }
+        const bool waiting_output = client.output_sent < client.output.size();
+        if (!waiting_output) {
+            client.output.clear();
+            client.output_sent = 0;
+        }
+        if (waiting_output != client.waiting_output) {
+            client.waiting_output = waiting_output;
+            Watch(client.fd, client_id, waiting_output ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+        }
+    }
+};
+
+/*
+*     : Call     .
+*/
+
+class DaemonClient {
+public:
+    explicit DaemonClient(const std::string& socket_path) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path is too long: " + socket_path);
+        }
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+            throw std::runtime_error("Cannot connect to " + socket_path);
+        }
+    }
+
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    ~DaemonClient() {
+        ::close(fd_);
+    }
+
+    DaemonResponse Call(const DaemonRequest& request) {
+        Transfer(const_cast<DaemonRequest*>(&request), sizeof(request), true);
+        DaemonResponse response;
+        Transfer(&response, sizeof(response), false);
+        return response;
+    }
+
+private:
+    int fd_;
+
+    void Transfer(void* data, size_t size, bool send) {
+        char* bytes = static_cast<char*>(data);
+        while (size != 0) {
+            const ssize_t transferred = send ? ::send(fd_, bytes, size, MSG_NOSIGNAL) :
+                ::recv(fd_, bytes, size, 0);
+            if (transferred <= 0) {
+                if (transferred < 0 && errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Connection to daemon lost");
+            }
+            bytes += transferred;
+            size -= transferred;
+        }
+    }
+};
+
+/*
+*           .
+*  shm_open     kSharedMemoryClientSlots 
+* .      CAS    
+*  ,  request_tail;       
+* ,          
+*   ,  response_tail.    
+* kSharedMemoryRingCapacity  ,   
+*         . 
+*     .
+*
+*   ,        .
+*      *_sleeping   
+* futex' (server_doorbell  response_doorbell),     ,
+*    ,      futex  .
+*        memory_order_seq_cst: 
+*         (),
+*        .
+*/
+
+constexpr uint32_t kSharedMemoryMagic = 0x4d4d5348;
+constexpr size_t kSharedMemoryClientSlots = 64;
+constexpr size_t kSharedMemoryRingCapacity = 256;
+
+struct SharedMemoryClientSlot {
+    alignas(64) std::atomic<uint32_t> claimed;
+    alignas(64) std::atomic<uint64_t> request_tail;
+    alignas(64) std::atomic<uint64_t> response_tail;
+    std::atomic<uint32_t> client_sleeping;
+    std::atomic<uint32_t> response_doorbell;
+    DaemonRequest requests[kSharedMemoryRingCapacity];
+    DaemonResponse responses[kSharedMemoryRingCapacity];
+};
+
+struct SharedMemorySegment {
+    uint32_t magic;
+    uint32_t slots_count;
+    alignas(64) std::atomic<uint32_t> server_sleeping;
+    std::atomic<uint32_t> server_doorbell;
+    SharedMemoryClientSlot slots[kSharedMemoryClientSlots];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "Shared memory rings need lock-free 64-bit atomics");
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// ,  *word  expected,    timeout_ns. Futex  
+//  ( FUTEX_PRIVATE_FLAG),      shm.
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, long timeout_ns);
+
+//    ,      
+// ;      .
+size_t SpinLimit(size_t spins);
+
+void FutexWake(std::atomic<uint32_t>* word);
+
+/*
+*    ;   ()
+*     .
+*/
+
+class SharedMemoryMapping {
+public:
+    SharedMemoryMapping(const std::string& name, bool create) :
+        name_(name),
+        owner_(create) {
+        const int fd = ::shm_open(name.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open shared memory " + name);
+        }
+        if (create && ::ftruncate(fd, sizeof(SharedMemorySegment)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("Cannot resize shared memory " + name);
+        }
+        void* data = ::mmap(nullptr, sizeof(SharedMemorySegment), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            if (create) {
+                ::shm_unlink(name.c_str());
+            }
+            throw std::runtime_error("Cannot map shared memory " + name);
+        }
+        segment_ = static_cast<SharedMemorySegment*>(data);
+    }
+
+    SharedMemoryMapping(const SharedMemoryMapping&) = delete;
+    SharedMemoryMapping& operator=(const SharedMemoryMapping&) = delete;
+
+    ~SharedMemoryMapping() {
+        ::munmap(segment_, sizeof(SharedMemorySegment));
+        if (owner_) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    SharedMemorySegment& operator*() const {
+        return *segment_;
+    }
+
+    SharedMemorySegment* operator->() const {
+        return segment_;
+    }
+
+private:
+    std::string name_;
+    bool owner_;
+    SharedMemorySegment* segment_;
+};
+
+/*
+*     :    
+*  ,   kIdleSweeps     futex',
+*       .
+*/
+
+class SharedMemoryAllocatorServer {
+public:
+    SharedMemoryAllocatorServer(size_t memory_size, const ReplayOptions& options) :
+        service_(memory_size, options) {}
+
+    void Serve(const std::string& name) {
+        SharedMemoryMapping segment(name, true);
+        segment->slots_count = kSharedMemoryClientSlots;
+        std::atomic_ref<uint32_t>(segment->magic).store(kSharedMemoryMagic, std::memory_order_release);
+        StopDaemonOnSignals();
+        std::vector<uint64_t> served(kSharedMemoryClientSlots, 0);
+        const size_t max_idle_sweeps = SpinLimit(kIdleSweeps);
+        size_t idle_sweeps = 0;
+        while (!daemon_stop_requested) {
+            if (Sweep(*segment, &served)) {
+                idle_sweeps = 0;
+                continue;
+            }
+            if (++idle_sweeps < max_idle_sweeps) {
+                CpuRelax();
+                continue;
+            }
+            const uint32_t doorbell = segment->server_doorbell.load();
+            segment->server_sleeping.store(1);
+            if (!HasRequests(*segment, served)) {
+                //  ,    .
+                FutexWait(&segment->server_doorbell, doorbell, kSleepTimeoutNs);
+            }
+            segment->server_sleeping.store(0);
+            idle_sweeps = 0;
+        }
+    }
+
+private:
+    static constexpr size_t kIdleSweeps = 1 << 12;
+    static constexpr long kSleepTimeoutNs = 100000000;
+
+    AllocatorService service_;
+
+    static bool HasRequests(SharedMemorySegment& segment, const std::vector<uint64_t>& served) {
+        for (size_t slot_index = 0; slot_index < kSharedMemoryClientSlots; ++slot_index) {
+            if (segment.slots[slot_index].request_tail.load() > served[slot_index]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    *     ; false,    .
+    * request_tail  ,    :    
+    *     kSharedMemoryRingCapacity , 
+    * request_tail,  ,    - 
+    *      ,   .
+    */
+    bool Sweep(SharedMemorySegment& segment, std::vector<uint64_t>* served) {
+        bool busy = false;
+        for (size_t slot_index = 0; slot_index < kSharedMemoryClientSlots; ++slot_index) {
+            SharedMemoryClientSlot& slot = segment.slots[slot_index];
+            if (slot.claimed.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            const uint64_t request_tail = slot.request_tail.load(std::memory_order_acquire);
+            uint64_t& response_tail = (*served)[slot_index];
+            if (response_tail == request_tail) {
+                continue;
+            }
+            if (request_tail < response_tail) {
+                response_tail = request_tail;
+                slot.response_tail.store(response_tail);
+                continue;
+            }
+            const uint64_t sweep_end =
+                std::min<uint64_t>(request_tail, response_tail + kSharedMemoryRingCapacity);
+            for (; response_tail != sweep_end; ++response_tail) {
+                const size_t index = response_tail % kSharedMemoryRingCapacity;
+                slot.responses[index] = service_.Execute(slot.requests[index]);
+            }
+            slot.response_tail.store(response_tail);
+            if (slot.client_sleeping.load()) {
+                FutexWake(&slot.response_doorbell);
+            }
+            busy = true;
+        }
+        return busy;
+    }
+};
+
+/*
+*     . Call   
+*    ,      -  futex'.
+*/
+
+class SharedMemoryClient {
+public:
+    explicit SharedMemoryClient(const std::string& name) :
+        segment_(name, false),
+        slot_(nullptr),
+        max_spins_(SpinLimit(kSpinsBeforeSleep)) {
+        if (std::atomic_ref<uint32_t>(segment_->magic).load(std::memory_order_acquire) !=
+            kSharedMemoryMagic) {
+            throw std::runtime_error("Shared memory " + name + " is not an allocator daemon");
+        }
+        for (SharedMemoryClientSlot& slot : segment_->slots) {
+            uint32_t expected = 0;
+            if (slot.claimed.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+                slot_ = &slot;
+                break;
+            }
+        }
+        if (slot_ == nullptr) {
+            throw std::runtime_error("No free client slots in shared memory " + name);
+        }
+        //       .
+        submitted_ = slot_->request_tail.load(std::memory_order_relaxed);
+        while (slot_->response_tail.load(std::memory_order_acquire) != submitted_) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    SharedMemoryClient(const SharedMemoryClient&) = delete;
+    SharedMemoryClient& operator=(const SharedMemoryClient&) = delete;
+
+    ~SharedMemoryClient() {
+        slot_->claimed.store(0, std::memory_order_release);
+    }
+
+    DaemonResponse Call(const DaemonRequest& request) {
+        const size_t index = submitted_ % kSharedMemoryRingCapacity;
+        slot_->requests[index] = request;
+        slot_->request_tail.store(++submitted_);
+        if (segment_->server_sleeping.load()) {
+            FutexWake(&segment_->server_doorbell);
+        }
+        for (size_t spins = 0; slot_->response_tail.load(std::memory_order_acquire) != submitted_;
+            ++spins) {
+            if (spins < max_spins_) {
+                CpuRelax();
+                continue;
+            }
+            const uint32_t doorbell = slot_->response_doorbell.load();
+            slot_->client_sleeping.store(1);
+            if (slot_->response_tail.load() != submitted_) {
+                FutexWait(&slot_->response_doorbell, doorbell, kSleepTimeoutNs);
+            }
+            slot_->client_sleeping.store(0);
+        }
+        return slot_->responses[index];
+    }
+
+private:
+    static constexpr size_t kSpinsBeforeSleep = 1 << 12;
+    static constexpr long kSleepTimeoutNs = 100000000;
+
+    SharedMemoryMapping segment_;
+    SharedMemoryClientSlot* slot_;
+    size_t max_spins_;
+    uint64_t submitted_;
+};
+
+/*
+*    : load_clients ,   
+* ,   load_requests ,  
+*    load_max_size    .
+*        .
+* Client - DaemonClient  SharedMemoryClient.
+*/
+template <class Client>
+void RunDaemonLoadTest(const ReplayOptions& options, std::ostream& ostream) {
+    constexpr size_t kMaxLiveAllocations = 256;
+    std::vector<std::vector<uint32_t>> latencies(options.load_clients);
+    std::vector<size_t> failed_allocations(options.load_clients, 0);
+    std::vector<std::exception_ptr> errors(options.load_clients);
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::thread> clients;
+        for (size_t client_index = 0; client_index < options.load_clients; ++client_index) {
+            clients.emplace_back([&, client_index] {
+                try {
+                    Client client(options.load_test_socket);
+                    std::mt19937_64 random(client_index + 1);
+                    std::vector<uint64_t> live_positions;
+                    latencies[client_index].reserve(options.load_requests);
+                    DaemonRequest request;
+                    std::memset(&request, 0, sizeof(request));
+                    for (size_t call = 0; call < options.load_requests; ++call) {
+                        const bool free = !live_positions.empty() &&
+                            (live_positions.size() == kMaxLiveAllocations || random() % 2 == 0);
+                        size_t freed = 0;
+                        if (free) {
+                            freed = random() % live_positions.size();
+                            request.type = DaemonRequestType::kFree;
+                            request.value = live_positions[freed];
+                        } else {
+                            request.type = DaemonRequestType::kAllocate;
+                            request.value = random() % options.load_max_size + 1;
+                        }
+                        const auto call_start = std::chrono::steady_clock::now();
+                        const DaemonResponse response = client.Call(request);
+                        latencies[client_index].push_back(static_cast<uint32_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - call_start).count()));
+                        if (free) {
+                            live_positions[freed] = live_positions.back();
+                            live_positions.pop_back();
+                        } else if (response.status == DaemonStatus::kOk) {
+                            live_positions.push_back(response.value);
+                        } else {
+                            ++failed_allocations[client_index];
+                        }
+                    }
+                    request.type = DaemonRequestType::kFree;
+                    for (uint64_t position : live_positions) {
+                        request.value = position;
+                        client.Call(request);
+                    }
+                } catch (...) {
+                    errors[client_index] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& client : clients) {
+            client.join();
+        }
+    }
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::vector<uint32_t> all_latencies;
+    size_t all_failed_allocations = 0;
+    for (size_t client_index = 0; client_index < options.load_clients; ++client_index) {
+        all_latencies.insert(all_latencies.end(),
+            latencies[client_index].begin(), latencies[client_index].end());
+        all_failed_allocations += failed_allocations[client_index];
+    }
+    std::sort(all_latencies.begin(), all_latencies.end());
+    auto percentile = [&](double share) -> double {
+        if (all_latencies.empty()) {
+            return 0;
+        }
+        return all_latencies[std::min(all_latencies.size() - 1,
+            static_cast<size_t>(share * all_latencies.size()))] / 1000.0;
+    };
+    ostream << "requests\t" << all_latencies.size() << "\n"
+        << "failed_allocations\t" << all_failed_allocations << "\n"
+        << "seconds\t" << seconds << "\n"
+        << "requests_per_second\t" << all_latencies.size() / seconds << "\n"
+        << "latency_p50_us\t" << percentile(0.5) << "\n"
+        << "latency_p99_us\t" << percentile(0.99) << "\n"
+        << "latency_p999_us\t" << percentile(0.999) << "\n"
+        << "latency_max_us\t" << percentile(1.0) << "\n";
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+*          
+*    .       
+*     index_change_observer.
+*/
+
+template <class T, class Compare = std::less<T>>
+class Heap {
+public:
+    using IndexChangeObserver =
+        std::function<void(const T& element, size_t new_element_index)>;
+
+    static constexpr size_t kNullIndex = static_cast<size_t>(-1);
+
+    explicit Heap(
+        Compare compare = Compare(),
+        IndexChangeObserver index_change_observer = IndexChangeObserver()) :
+        compare_(compare),
+        index_change_observer_(index_change_observer) {}
+
+    size_t push(const T& value) {
+        elements_.push_back(value);
+        NotifyIndexChange(value, size() - 1);
+        return SiftUp(size() - 1);
+    }
+
+    void erase(size_t index) {
+        if (index != size() - 1) {
+            SwapElements(index, size() - 1);
+            NotifyIndexChange(elements_[size() - 1], kNullIndex);
+            elements_.pop_back();
+            SiftDown(index);
+            SiftUp(index);
+        }
+        else if (index == size() - 1) {
+            NotifyIndexChange(elements_[size() - 1], kNullIndex);
+            elements_.pop_back();
+        }
+    }
+
+    const T& top() const {
+        return elements_[0];
+    }
+
+    void pop() {
+        erase(0);
+        return;
+    }
+
+    size_t size() const {
+        return elements_.size();
+    }
+
+    bool empty() const {
+        return elements_.empty();
+    }
+
+private:
+    IndexChangeObserver index_change_observer_;
+    Compare compare_;
+    std::vector<T> elements_;
+
+    size_t Parent(size_t index) const {
+        return (index - 1) / 2;
+    }
+
+    size_t LeftSon(size_t index) const {
+        return 2 * index + 1;
+    }
+
+    size_t RightSon(size_t index) const {
+        return 2 * index + 2;
+    }
+
+    bool CompareElements(size_t first_index, size_t second_index) const {
+        return compare_(elements_[first_index], elements_[second_index]);
+    }
+
+    void NotifyIndexChange(const T& element, size_t new_element_index) {
+        if (index_change_observer_) {
+            index_change_observer_(element, new_element_index);
+        }
+    }
+
+    void SwapElements(size_t first_index, size_t second_index) {
+        std::swap(elements_[first_index], elements_[second_index]);
+        NotifyIndexChange(elements_[first_index], first_index);
+        NotifyIndexChange(elements_[second_index], second_index);
+    }
+
+    size_t SiftUp(size_t index) {
+        if (index == 0) {
+            return index;
+        }
+        while ((index != 0) && (CompareElements(index, Parent(index)))) {
+            SwapElements(index, Parent(index));
+            index = Parent(index);
+        }
+        return index;
+    }
+
+    void SiftDown(size_t index) {
+        if (index + 1 == size()) {
+            return;
+        }
+        size_t leftIndex = LeftSon(index);
+        size_t rightIndex = RightSon(index);
+
+        while (leftIndex < elements_.size()) {
+            size_t sonIndex = leftIndex;
+            if (rightIndex < elements_.size() && CompareElements(rightIndex, leftIndex))
+                sonIndex = rightIndex;
+
+            if (CompareElements(index, sonIndex)) {
+                return;
+            }
+
+            SwapElements(index, sonIndex);
+            index = sonIndex;
+
+            leftIndex = LeftSon(index);
+            rightIndex = RightSon(index);
+        }
+    }
+};
+
+using DefaultHeap = Heap<int, std::less<int>>;
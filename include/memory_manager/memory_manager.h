@@ -0,0 +1,1198 @@
+#pragma once
+
+#include "memory_manager/heap.h"
+#include "memory_manager/radix_tree.h"
+
+#include <algorithm>
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using TenantId = uint32_t;
+
+constexpr TenantId kDefaultTenant = 0;
+
+struct MemorySegment {
+    int left;
+    int right;
+    size_t heap_index;
+    TenantId tenant;
+
+    MemorySegment(int left, int right) :
+        left(left),
+        right(right),
+        heap_index(DefaultHeap::kNullIndex),
+        tenant(kDefaultTenant) {}
+
+    size_t Size() const {
+        return right - left + 1;
+    }
+
+    MemorySegment Unite(const MemorySegment& other) const {
+
+        int uniteLeft = std::min(left, other.left);
+        int uniteRight = std::max(right, other.right);
+        return MemorySegment(uniteLeft, uniteRight);
+    }
+};
+
+using MemorySegmentIterator = std::list<MemorySegment>::iterator;
+using MemorySegmentConstIterator = std::list<MemorySegment>::const_iterator;
+
+
+struct MemorySegmentSizeCompare {
+    bool operator() (MemorySegmentIterator first,
+        MemorySegmentIterator second) const {
+        return std::make_pair(first->Size(), -first->left) >
+               std::make_pair(second->Size(), -second->left);
+    }
+};
+
+
+using MemorySegmentHeap =
+Heap<MemorySegmentIterator, MemorySegmentSizeCompare>;
+
+
+struct MemorySegmentsHeapObserver {
+    void operator() (MemorySegmentIterator segment, size_t new_index) const
+    {
+        segment->heap_index = new_index;
+    }
+};
+
+/*
+*   (treap)  ,   
+* .       
+*   ,    O(log n)   
+*       ,  
+*       O(1).    
+*    ,   .
+*/
+
+class FreeSegmentAddressIndex {
+public:
+    void Insert(MemorySegmentIterator segment) {
+        int32_t node;
+        if (free_nodes_.empty()) {
+            node = nodes_.size();
+            nodes_.emplace_back();
+        } else {
+            node = free_nodes_.back();
+            free_nodes_.pop_back();
+        }
+        nodes_[node] = Node{ segment, static_cast<size_t>(segment->left),
+            segment->Size(), segment->Size(), NextPriority(), kNullNode, kNullNode };
+        int32_t less;
+        int32_t greater;
+        Split(root_, nodes_[node].key, &less, &greater);
+        root_ = Merge(Merge(less, node), greater);
+    }
+
+    void Erase(size_t key) {
+        int32_t less;
+        int32_t equal;
+        int32_t greater;
+        Split(root_, key, &less, &greater);
+        Split(greater, key + 1, &equal, &greater);
+        if (equal != kNullNode) {
+            free_nodes_.push_back(equal);
+        }
+        root_ = Merge(less, greater);
+    }
+
+    /*
+    *       size,   [from, to],
+    *  nullptr,   .
+    */
+    const MemorySegmentIterator* FindFirstFit(size_t size, size_t from,
+        size_t to = static_cast<size_t>(-1)) const {
+        return SegmentOf(FindFirstFit(root_, size, from, to));
+    }
+
+    /*
+    *       size,   before,
+    *  nullptr,   .
+    */
+    const MemorySegmentIterator* FindLastFit(size_t size, size_t before) const {
+        return SegmentOf(FindLastFit(root_, size, before));
+    }
+
+    size_t MaxSize() const {
+        return MaxSize(root_);
+    }
+
+private:
+    static constexpr int32_t kNullNode = -1;
+
+    struct Node {
+        MemorySegmentIterator segment;
+        size_t key;
+        size_t size;
+        size_t max_size;
+        uint32_t priority;
+        int32_t left;
+        int32_t right;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<int32_t> free_nodes_;
+    int32_t root_ = kNullNode;
+    uint32_t random_state_ = 2463534242u;
+
+    uint32_t NextPriority() {
+        random_state_ ^= random_state_ << 13;
+        random_state_ ^= random_state_ >> 17;
+        random_state_ ^= random_state_ << 5;
+        return random_state_;
+    }
+
+    size_t MaxSize(int32_t node) const {
+        return node == kNullNode ? 0 : nodes_[node].max_size;
+    }
+
+    const MemorySegmentIterator* SegmentOf(int32_t node) const {
+        return node == kNullNode ? nullptr : &nodes_[node].segment;
+    }
+
+    void Update(int32_t node) {
+        nodes_[node].max_size = std::max(nodes_[node].size,
+            std::max(MaxSize(nodes_[node].left), MaxSize(nodes_[node].right)));
+    }
+
+    //        key    key.
+    void Split(int32_t node, size_t key, int32_t* less, int32_t* greater) {
+        if (node == kNullNode) {
+            *less = kNullNode;
+            *greater = kNullNode;
+        } else if (nodes_[node].key < key) {
+            Split(nodes_[node].right, key, &nodes_[node].right, greater);
+            *less = node;
+            Update(node);
+        } else {
+            Split(nodes_[node].left, key, less, &nodes_[node].left);
+            *greater = node;
+            Update(node);
+        }
+    }
+
+    int32_t Merge(int32_t less, int32_t greater) {
+        if (less == kNullNode) {
+            return greater;
+        }
+        if (greater == kNullNode) {
+            return less;
+        }
+        if (nodes_[less].priority > nodes_[greater].priority) {
+            nodes_[less].right = Merge(nodes_[less].right, greater);
+            Update(less);
+            return less;
+        }
+        nodes_[greater].left = Merge(less, nodes_[greater].left);
+        Update(greater);
+        return greater;
+    }
+
+    int32_t FindFirstFit(int32_t node, size_t size, size_t from, size_t to) const {
+        if (node == kNullNode || nodes_[node].max_size < size) {
+            return kNullNode;
+        }
+        if (nodes_[node].key < from) {
+            return FindFirstFit(nodes_[node].right, size, from, to);
+        }
+        const int32_t left_fit = FindFirstFit(nodes_[node].left, size, from, to);
+        if (left_fit != kNullNode || nodes_[node].key > to) {
+            return left_fit;
+        }
+        if (nodes_[node].size >= size) {
+            return node;
+        }
+        return FindFirstFit(nodes_[node].right, size, from, to);
+    }
+
+    int32_t FindLastFit(int32_t node, size_t size, size_t before) const {
+        if (node == kNullNode || nodes_[node].max_size < size) {
+            return kNullNode;
+        }
+        if (nodes_[node].key >= before) {
+            return FindLastFit(nodes_[node].left, size, before);
+        }
+        const int32_t right_fit = FindLastFit(nodes_[node].right, size, before);
+        if (right_fit != kNullNode) {
+            return right_fit;
+        }
+        if (nodes_[node].size >= size) {
+            return node;
+        }
+        return FindLastFit(nodes_[node].left, size, before);
+    }
+};
+
+struct TenantLimits {
+    static constexpr size_t kUnlimited = static_cast<size_t>(-1);
+
+    //    ,    .
+    size_t soft_quota = kUnlimited;
+    //     .
+    size_t hard_quota = kUnlimited;
+    //   ,       .
+    size_t reservation = 0;
+};
+
+struct TenantUsage {
+    size_t used = 0;
+    size_t soft_quota_violations = 0;
+    size_t rejected_allocations = 0;
+};
+
+/*
+*    (tenants)  MemoryManager.  
+*      ,     - 
+*        .  ,
+*   O(1)       ,   
+*  size :       ,  
+*       ,  
+*  .
+*/
+
+class TenantQuotas {
+public:
+    static constexpr TenantId kMaxTenants = 1 << 16;
+
+    explicit TenantQuotas(size_t memory_size) :
+        free_memory_(memory_size),
+        unused_reservations_(0) {}
+
+    void SetLimits(TenantId tenant, const TenantLimits& limits) {
+        Tenant& state = GetTenant(tenant);
+        unused_reservations_ -= UnusedReservation(state);
+        state.limits = limits;
+        unused_reservations_ += UnusedReservation(state);
+    }
+
+    static void CheckTenant(TenantId tenant) {
+        if (tenant >= kMaxTenants) {
+            throw std::out_of_range("TenantId is too large");
+        }
+    }
+
+    bool CanAllocate(TenantId tenant, size_t size) const {
+        if (tenant >= kMaxTenants) {
+            return false;
+        }
+        if (tenant >= tenants_.size()) {
+            return size <= free_memory_ && free_memory_ - size >= unused_reservations_;
+        }
+        const Tenant& state = tenants_[tenant];
+        if (state.usage.used + size > state.limits.hard_quota) {
+            return false;
+        }
+        const size_t other_reservations = unused_reservations_ - UnusedReservation(state);
+        return size <= free_memory_ && free_memory_ - size >= other_reservations;
+    }
+
+    //   size        .
+    bool WithinHardQuota(TenantId tenant, size_t size) const {
+        return tenant >= tenants_.size() ||
+            tenants_[tenant].usage.used + size <= tenants_[tenant].limits.hard_quota;
+    }
+
+    void OnAllocate(TenantId tenant, size_t size) {
+        Tenant& state = GetTenant(tenant);
+        unused_reservations_ -= UnusedReservation(state);
+        state.usage.used += size;
+        unused_reservations_ += UnusedReservation(state);
+        free_memory_ -= size;
+        if (state.usage.used > state.limits.soft_quota) {
+            ++state.usage.soft_quota_violations;
+        }
+    }
+
+    void OnFree(TenantId tenant, size_t size) {
+        Tenant& state = GetTenant(tenant);
+        unused_reservations_ -= UnusedReservation(state);
+        state.usage.used -= size;
+        unused_reservations_ += UnusedReservation(state);
+        free_memory_ += size;
+    }
+
+    void OnReject(TenantId tenant) {
+        ++GetTenant(tenant).usage.rejected_allocations;
+    }
+
+    TenantUsage Usage(TenantId tenant) const {
+        return tenant < tenants_.size() ? tenants_[tenant].usage : TenantUsage();
+    }
+
+private:
+    struct Tenant {
+        TenantLimits limits;
+        TenantUsage usage;
+    };
+
+    std::vector<Tenant> tenants_;
+    size_t free_memory_;
+    size_t unused_reservations_;
+
+    static size_t UnusedReservation(const Tenant& state) {
+        return state.usage.used < state.limits.reservation ?
+            state.limits.reservation - state.usage.used : 0;
+    }
+
+    Tenant& GetTenant(TenantId tenant) {
+        CheckTenant(tenant);
+        if (tenant >= tenants_.size()) {
+            tenants_.resize(tenant + 1);
+        }
+        return tenants_[tenant];
+    }
+};
+
+/*
+*   : kLevels   kSlots , 
+*  L  kSlots^L .     
+* ,         ,  
+*      ,    .
+*         overflow_. 
+*   ,  Advance   
+*  ,     .
+*/
+
+template <class Payload>
+class HierarchicalTimerWheel {
+public:
+    using Tick = uint64_t;
+
+    void Schedule(Tick deadline, Payload payload) {
+        ++size_;
+        Insert(Entry{ deadline, std::move(payload) }, nullptr);
+    }
+
+    //    now    expired   .
+    void Advance(Tick now, std::vector<Payload>* expired) {
+        while (!due_.empty()) {
+            expired->push_back(std::move(due_.back().payload));
+            due_.pop_back();
+            --size_;
+        }
+        while (now_ < now) {
+            if (size_ == 0) {
+                now_ = now;
+                break;
+            }
+            size_t empty_levels = 0;
+            while (empty_levels < kLevels && occupied_slots_[empty_levels] == 0) {
+                ++empty_levels;
+            }
+            if (empty_levels > 0) {
+                const Tick period = Tick(1) << (kSlotBits * empty_levels);
+                now_ = std::min(now, (now_ | (period - 1)));
+                if (now_ == now) {
+                    break;
+                }
+            }
+            ProcessTick(now_ + 1, expired);
+        }
+    }
+
+    Tick Now() const {
+        return now_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 6;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+
+    struct Entry {
+        Tick deadline;
+        Payload payload;
+    };
+
+    std::array<std::array<std::vector<Entry>, kSlots>, kLevels> slots_;
+    std::array<uint64_t, kLevels> occupied_slots_ = {};
+    std::vector<Entry> overflow_;
+    std::vector<Entry> due_;
+    Tick now_ = 0;
+    size_t size_ = 0;
+
+    static size_t SlotIndex(Tick tick, size_t level) {
+        return (tick >> (kSlotBits * level)) & (kSlots - 1);
+    }
+
+    void Insert(Entry entry, std::vector<Payload>* expired) {
+        if (entry.deadline <= now_) {
+            if (expired != nullptr) {
+                expired->push_back(std::move(entry.payload));
+                --size_;
+            } else {
+                due_.push_back(std::move(entry));
+            }
+            return;
+        }
+        for (size_t level = 0; level < kLevels; ++level) {
+            const size_t epoch_bits = kSlotBits * (level + 1);
+            if ((entry.deadline >> epoch_bits) == (now_ >> epoch_bits)) {
+                const size_t slot = SlotIndex(entry.deadline, level);
+                slots_[level][slot].push_back(std::move(entry));
+                occupied_slots_[level] |= uint64_t(1) << slot;
+                return;
+            }
+        }
+        overflow_.push_back(std::move(entry));
+    }
+
+    void ProcessTick(Tick tick, std::vector<Payload>* expired) {
+        now_ = tick;
+        if ((tick & ((Tick(1) << (kSlotBits * kLevels)) - 1)) == 0) {
+            std::vector<Entry> overflow;
+            overflow.swap(overflow_);
+            for (Entry& entry : overflow) {
+                Insert(std::move(entry), expired);
+            }
+        }
+        for (size_t level = kLevels - 1; level > 0; --level) {
+            if ((tick & ((Tick(1) << (kSlotBits * level)) - 1)) == 0) {
+                Cascade(level, SlotIndex(tick, level), expired);
+            }
+        }
+        Cascade(0, SlotIndex(tick, 0), expired);
+    }
+
+    void Cascade(size_t level, size_t slot, std::vector<Payload>* expired) {
+        if ((occupied_slots_[level] >> slot & 1) == 0) {
+            return;
+        }
+        std::vector<Entry> entries;
+        entries.swap(slots_[level][slot]);
+        occupied_slots_[level] &= ~(uint64_t(1) << slot);
+        for (Entry& entry : entries) {
+            Insert(std::move(entry), expired);
+        }
+    }
+};
+
+enum class AllocationPolicy {
+    kLargestFirst,
+    kNextFit
+};
+
+/*
+*      :
+* kFifo -    ,   
+*  ; kSmallestFirst -    
+* (  -  ); kFirstFit -   , 
+* ,    , .
+* ,      ,   
+* ,     ,     
+*     .
+*/
+enum class WaitingQueuePolicy {
+    kFifo,
+    kSmallestFirst,
+    kFirstFit
+};
+
+/*
+* ,   CoroutineExecutor.  
+* ,       .
+*/
+
+class AsyncTask {
+public:
+    struct promise_type {
+        AsyncTask get_return_object() {
+            return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    AsyncTask(AsyncTask&& other) noexcept :
+        handle_(std::exchange(other.handle_, nullptr)) {}
+
+    AsyncTask& operator=(AsyncTask&& other) = delete;
+
+    ~AsyncTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<> Release() {
+        return std::exchange(handle_, nullptr);
+    }
+
+private:
+    explicit AsyncTask(std::coroutine_handle<promise_type> handle) :
+        handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/*
+*   :    
+* ,      Run.   
+*   ; Run ,    
+*  (      ).
+*/
+
+class CoroutineExecutor {
+public:
+    void Spawn(AsyncTask task) {
+        Post(task.Release());
+    }
+
+    void Post(std::coroutine_handle<> handle) {
+        ready_.push_back(handle);
+    }
+
+    void Run() {
+        while (!ready_.empty()) {
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            handle.resume();
+        }
+    }
+
+private:
+    std::deque<std::coroutine_handle<>> ready_;
+};
+
+/*
+*        (std::list).
+*         
+*    ,   (  
+*   )      std::list::iterator.
+*          ,
+*       heap_index,  
+*    index_change_observer.     
+*    :      heap_index
+*  kNullIndex.
+*     radix-   ,
+*      ,    
+* ,      .   
+*  Find,  ,     , 
+*      Allocate  Free.
+*      FreeSegmentAddressIndex,  
+* :    next-fit,    
+* ,      (rover_),  
+*   AllocateInRange  AllocateNear.  
+* kLargestFirst        ,
+*   Allocate  Free     .
+*     ,   ; 
+*   TenantQuotas   .
+*   AllocateBatch    (undo log),  
+*     ,     
+* ;       .
+*  AllocateOrWait,     ,  
+*      Free    ;
+*    callback.     awaitable
+* AllocateAsync  .
+* ,   AllocateWithTtl,  ,
+*  AdvanceTime       . 
+*      ;  Free 
+*    active_leases_,      .
+*/
+
+class MemoryManager {
+public:
+    using Iterator = MemorySegmentIterator;
+    using ConstIterator = MemorySegmentConstIterator;
+
+    using WaitTicket = uint64_t;
+    using Tick = uint64_t;
+    using AllocationCallback = std::function<void(Iterator segment)>;
+
+    static constexpr size_t kNullPosition = 0;
+    static constexpr WaitTicket kCompletedTicket = 0;
+
+    explicit MemoryManager(size_t memory_size,
+        AllocationPolicy policy = AllocationPolicy::kLargestFirst) :
+        free_memory_segments_(MemorySegmentSizeCompare(),
+            MemorySegmentsHeapObserver()),
+        tenant_quotas_(memory_size),
+        policy_(policy),
+        rover_(1),
+        address_index_enabled_(policy == AllocationPolicy::kNextFit) {
+        memory_segments_.push_back(MemorySegment(1, memory_size));
+        AddFreeSegment(memory_segments_.begin());
+    }
+
+    Iterator Allocate(size_t size, TenantId tenant = kDefaultTenant) {
+        if (!AdmitTenant(tenant, size)) {
+            return end();
+        }
+        Iterator segment = FindFreeSegment(size);
+        if (segment == end()) {
+            return end();
+        }
+        return Carve(segment, segment->left, size, tenant);
+    }
+
+    /*
+    *    size    ttl   .
+    */
+    Iterator AllocateWithTtl(size_t size, Tick ttl, TenantId tenant = kDefaultTenant) {
+        Iterator segment = Allocate(size, tenant);
+        if (segment != end()) {
+            const uint64_t lease_id = next_lease_id_++;
+            active_leases_[segment->left] = lease_id;
+            lease_wheel_.Schedule(lease_wheel_.Now() + ttl, Lease{
+                static_cast<size_t>(segment->left), lease_id });
+        }
+        return segment;
+    }
+
+    /*
+    *     now     
+    *    :    
+    *     .
+    */
+    void AdvanceTime(Tick now) {
+        std::vector<Lease> expired_leases;
+        lease_wheel_.Advance(now, &expired_leases);
+        const bool serving_waiting_allocations = serving_waiting_allocations_;
+        serving_waiting_allocations_ = true;
+        for (const Lease& lease : expired_leases) {
+            auto active_lease = active_leases_.find(lease.position);
+            if (active_lease != active_leases_.end() && active_lease->second == lease.id) {
+                Free(Find(lease.position));
+            }
+        }
+        serving_waiting_allocations_ = serving_waiting_allocations;
+        ServeWaitingAllocations();
+    }
+
+    Tick Now() const {
+        return lease_wheel_.Now();
+    }
+
+    /*
+    *    size     callback.  
+    *   ,        
+    *     Free;   ,  
+    *   .  callback  , 
+    * kCompletedTicket.
+    */
+    WaitTicket AllocateOrWait(size_t size, AllocationCallback callback,
+        TenantId tenant = kDefaultTenant) {
+        TenantQuotas::CheckTenant(tenant);
+        if (waiting_queue_policy_ != WaitingQueuePolicy::kFifo ||
+            !HasMemoryBoundWaiting()) {
+            Iterator segment = Allocate(size, tenant);
+            if (segment != end()) {
+                callback(segment);
+                return kCompletedTicket;
+            }
+        }
+        const WaitTicket ticket = next_wait_ticket_++;
+        waiting_by_arrival_.emplace(ticket, WaitingAllocation{ size, tenant, std::move(callback) });
+        waiting_by_size_.emplace(size, ticket);
+        return ticket;
+    }
+
+    /*
+    * Awaitable  co_await:   ,   , 
+    *        
+    * .    executor,      -
+    *     Free.    
+    * ,    .
+    */
+    class AllocationAwaiter {
+    public:
+        AllocationAwaiter(MemoryManager& memory, size_t size, TenantId tenant,
+            CoroutineExecutor* executor) :
+            memory_(memory),
+            size_(size),
+            tenant_(tenant),
+            executor_(executor),
+            segment_(memory.end()),
+            suspended_(false) {}
+
+        bool await_ready() const {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            const WaitTicket ticket = memory_.AllocateOrWait(size_,
+                [this, handle](Iterator segment) {
+                    segment_ = segment;
+                    if (!suspended_) {
+                        return;
+                    }
+                    if (executor_ != nullptr) {
+                        executor_->Post(handle);
+                    } else {
+                        handle.resume();
+                    }
+                }, tenant_);
+            suspended_ = ticket != kCompletedTicket;
+            return suspended_;
+        }
+
+        Iterator await_resume() const {
+            return segment_;
+        }
+
+    private:
+        MemoryManager& memory_;
+        size_t size_;
+        TenantId tenant_;
+        CoroutineExecutor* executor_;
+        Iterator segment_;
+        bool suspended_;
+    };
+
+    AllocationAwaiter AllocateAsync(size_t size, CoroutineExecutor* executor = nullptr,
+        TenantId tenant = kDefaultTenant) {
+        return AllocationAwaiter(*this, size, tenant, executor);
+    }
+
+    bool CancelWait(WaitTicket ticket) {
+        auto waiting = waiting_by_arrival_.find(ticket);
+        if (waiting == waiting_by_arrival_.end()) {
+            return false;
+        }
+        waiting_by_size_.erase(std::make_pair(waiting->second.size, ticket));
+        waiting_by_arrival_.erase(waiting);
+        //       kFifo, 
+        //     .
+        ServeWaitingAllocations();
+        return true;
+    }
+
+    size_t WaitingCount() const {
+        return waiting_by_arrival_.size();
+    }
+
+    void SetWaitingQueuePolicy(WaitingQueuePolicy policy) {
+        waiting_queue_policy_ = policy;
+    }
+
+    /*
+    *       sizes ,     
+    *   ,      
+    *  false.     segments.
+    *        : 
+    *   ,        
+    * ,      rejected_allocations  .
+    */
+    bool AllocateBatch(std::span<const size_t> sizes, std::vector<Iterator>* segments,
+        TenantId tenant = kDefaultTenant) {
+        segments->clear();
+        //  :      .
+        const size_t max_size = std::numeric_limits<size_t>::max();
+        size_t total_size = 0;
+        for (size_t size : sizes) {
+            total_size = size > max_size - total_size ? max_size : total_size + size;
+        }
+        if (!AdmitTenant(tenant, total_size)) {
+            return false;
+        }
+        std::vector<CarveRecord> undo_log;
+        undo_log_ = &undo_log;
+        const size_t rover = rover_;
+        try {
+            for (size_t size : sizes) {
+                Iterator segment = Allocate(size, tenant);
+                if (segment == end()) {
+                    RollBackBatch(undo_log, rover);
+                    segments->clear();
+                    return false;
+                }
+                segments->push_back(segment);
+            }
+        } catch (...) {
+            // undo_log_     .
+            RollBackBatch(undo_log, rover);
+            segments->clear();
+            throw;
+        }
+        undo_log_ = nullptr;
+        return true;
+    }
+
+    /*
+    *    size,    [lo, hi],  
+    *   .   O(log n).
+    */
+    Iterator AllocateInRange(size_t size, size_t lo, size_t hi,
+        TenantId tenant = kDefaultTenant) {
+        if (size == 0 || lo > hi || hi - lo + 1 < size || !AdmitTenant(tenant, size)) {
+            return end();
+        }
+        EnableAddressIndex();
+        const Iterator* containing = free_segments_by_address_.FindLastFit(1, lo + 1);
+        if (containing != nullptr) {
+            const size_t available_right =
+                std::min(static_cast<size_t>((*containing)->right), hi);
+            if (available_right >= lo && available_right - lo + 1 >= size) {
+                return Carve(*containing, lo, size, tenant);
+            }
+        }
+        const Iterator* segment =
+            free_segments_by_address_.FindFirstFit(size, lo, hi - size + 1);
+        if (segment == nullptr) {
+            return end();
+        }
+        return Carve(*segment, (*segment)->left, size, tenant);
+    }
+
+    /*
+    *    size,      hint
+    * (     ).   O(log n).
+    */
+    Iterator AllocateNear(size_t size, size_t hint, TenantId tenant = kDefaultTenant) {
+        if (size == 0 || !AdmitTenant(tenant, size)) {
+            return end();
+        }
+        EnableAddressIndex();
+        const Iterator* left_segment = free_segments_by_address_.FindLastFit(size, hint + 1);
+        const Iterator* right_segment = free_segments_by_address_.FindFirstFit(size, hint + 1);
+        if (left_segment == nullptr && right_segment == nullptr) {
+            return end();
+        }
+        size_t left_position = 0;
+        if (left_segment != nullptr) {
+            left_position = std::min(hint, (*left_segment)->right - size + 1);
+        }
+        if (right_segment == nullptr ||
+            (left_segment != nullptr &&
+             hint - left_position <= (*right_segment)->left - hint)) {
+            return Carve(*left_segment, left_position, size, tenant);
+        }
+        return Carve(*right_segment, (*right_segment)->left, size, tenant);
+    }
+
+    /*
+    *   ,    position,
+    *  end(),    .
+    */
+    Iterator Find(size_t position) {
+        EnablePositionIndex();
+        Iterator* segment = allocated_segments_.Find(position);
+        if (segment == nullptr) {
+            return end();
+        }
+        return *segment;
+    }
+
+    void Free(size_t position) {
+        Iterator segment = Find(position);
+        if (segment != end()) {
+            Free(segment);
+        }
+    }
+
+    void Free(Iterator position) {
+        if (position_index_enabled_) {
+            allocated_segments_.Erase(position->left);
+        }
+        if (!active_leases_.empty()) {
+            active_leases_.erase(position->left);
+        }
+        tenant_quotas_.OnFree(position->tenant, position->Size());
+        if (position != memory_segments_.begin()) {
+            AppendIfFree(position, std::prev(position));
+        }
+        if (std::next(position) != memory_segments_.end()) {
+            AppendIfFree(position, std::next(position));
+        }
+        AddFreeSegment(position);
+        ServeWaitingAllocations();
+    }
+
+    Iterator end() {
+        return memory_segments_.end();
+    }
+
+    ConstIterator end() const {
+        return memory_segments_.cend();
+    }
+
+    void SetTenantLimits(TenantId tenant, const TenantLimits& limits) {
+        tenant_quotas_.SetLimits(tenant, limits);
+    }
+
+    TenantUsage GetTenantUsage(TenantId tenant) const {
+        return tenant_quotas_.Usage(tenant);
+    }
+
+private:
+    struct WaitingAllocation {
+        size_t size;
+        TenantId tenant;
+        AllocationCallback callback;
+    };
+
+    struct Lease {
+        size_t position;
+        uint64_t id;
+    };
+
+    struct CarveRecord {
+        Iterator segment;
+        bool has_left_part;
+        bool has_right_part;
+    };
+
+    MemorySegmentHeap free_memory_segments_;
+    std::list<MemorySegment> memory_segments_;
+    RadixTree<Iterator> allocated_segments_;
+    FreeSegmentAddressIndex free_segments_by_address_;
+    TenantQuotas tenant_quotas_;
+    AllocationPolicy policy_;
+    size_t rover_;
+    bool address_index_enabled_;
+    bool position_index_enabled_ = false;
+    std::vector<CarveRecord>* undo_log_ = nullptr;
+    std::map<WaitTicket, WaitingAllocation> waiting_by_arrival_;
+    std::set<std::pair<size_t, WaitTicket>> waiting_by_size_;
+    WaitingQueuePolicy waiting_queue_policy_ = WaitingQueuePolicy::kFifo;
+    WaitTicket next_wait_ticket_ = kCompletedTicket + 1;
+    bool serving_waiting_allocations_ = false;
+    HierarchicalTimerWheel<Lease> lease_wheel_;
+    std::unordered_map<size_t, uint64_t> active_leases_;
+    uint64_t next_lease_id_ = 0;
+
+    size_t MaxFreeSize() const {
+        return free_memory_segments_.empty() ? 0 : free_memory_segments_.top()->Size();
+    }
+
+    /*
+    *    ,   . Callback' 
+    *   Free  AllocateOrWait:   Free 
+    *   ,     ,  
+    *        .
+    */
+    //    ,   ,    .
+    bool HasMemoryBoundWaiting() const {
+        for (const auto& waiting : waiting_by_arrival_) {
+            if (tenant_quotas_.WithinHardQuota(waiting.second.tenant, waiting.second.size)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ServeWaitingAllocations() {
+        if (serving_waiting_allocations_) {
+            return;
+        }
+        serving_waiting_allocations_ = true;
+        while (!waiting_by_size_.empty() &&
+               waiting_by_size_.begin()->first <= MaxFreeSize()) {
+            auto waiting = waiting_by_arrival_.end();
+            Iterator segment = end();
+            if (waiting_queue_policy_ == WaitingQueuePolicy::kSmallestFirst) {
+                for (const auto& waiting_size : waiting_by_size_) {
+                    if (waiting_size.first > MaxFreeSize()) {
+                        break;
+                    }
+                    waiting = waiting_by_arrival_.find(waiting_size.second);
+                    if (tenant_quotas_.WithinHardQuota(waiting->second.tenant,
+                                                       waiting->second.size)) {
+                        segment = Allocate(waiting->second.size, waiting->second.tenant);
+                        break;
+                    }
+                }
+            } else {
+                for (waiting = waiting_by_arrival_.begin();
+                     waiting != waiting_by_arrival_.end(); ++waiting) {
+                    if (!tenant_quotas_.WithinHardQuota(waiting->second.tenant,
+                                                        waiting->second.size)) {
+                        continue;
+                    }
+                    if (waiting->second.size <= MaxFreeSize()) {
+                        segment = Allocate(waiting->second.size, waiting->second.tenant);
+                    }
+                    if (segment != end() ||
+                        waiting_queue_policy_ == WaitingQueuePolicy::kFifo) {
+                        break;
+                    }
+                }
+            }
+            if (segment == end()) {
+                break;
+            }
+            AllocationCallback callback = std::move(waiting->second.callback);
+            waiting_by_size_.erase(std::make_pair(waiting->second.size, waiting->first));
+            waiting_by_arrival_.erase(waiting);
+            callback(segment);
+        }
+        serving_waiting_allocations_ = false;
+    }
+
+    Iterator FindFreeSegment(size_t size) {
+        if (free_memory_segments_.empty()) {
+            return end();
+        }
+        if (policy_ == AllocationPolicy::kLargestFirst) {
+            Iterator topElement = free_memory_segments_.top();
+            return topElement->Size() < size ? end() : topElement;
+        }
+        if (free_segments_by_address_.MaxSize() < size) {
+            return end();
+        }
+        const Iterator* segment = free_segments_by_address_.FindFirstFit(size, rover_);
+        if (segment == nullptr) {
+            segment = free_segments_by_address_.FindFirstFit(size, 0);
+        }
+        return *segment;
+    }
+
+    /*
+    *  [position, position + size)    segment.
+    *         .
+    */
+    Iterator Carve(Iterator segment, size_t position, size_t size, TenantId tenant) {
+        RemoveFreeSegment(segment);
+        const bool has_left_part = static_cast<size_t>(segment->left) != position;
+        const bool has_right_part = segment->Size() - (position - segment->left) != size;
+        if (has_left_part) {
+            Iterator leftPart = memory_segments_.insert(segment,
+                MemorySegment(segment->left, position - 1));
+            segment->left = position;
+            AddFreeSegment(leftPart);
+        }
+        if (has_right_part) {
+            Iterator rightPart = memory_segments_.insert(std::next(segment),
+                MemorySegment(position + size, segment->right));
+            segment->right = position + size - 1;
+            AddFreeSegment(rightPart);
+        }
+        segment->tenant = tenant;
+        tenant_quotas_.OnAllocate(tenant, size);
+        if (position_index_enabled_) {
+            allocated_segments_.Insert(segment->left, segment);
+        }
+        rover_ = segment->right + 1;
+        if (undo_log_ != nullptr) {
+            undo_log_->push_back(CarveRecord{ segment, has_left_part, has_right_part });
+        }
+        return segment;
+    }
+
+    //   Carve     .
+    void RollBackBatch(const std::vector<CarveRecord>& undo_log, size_t rover) {
+        undo_log_ = nullptr;
+        for (auto record = undo_log.rbegin(); record != undo_log.rend(); ++record) {
+            Uncarve(*record);
+        }
+        rover_ = rover;
+    }
+
+    //  Carve:        .
+    void Uncarve(const CarveRecord& record) {
+        Iterator segment = record.segment;
+        if (position_index_enabled_) {
+            allocated_segments_.Erase(segment->left);
+        }
+        tenant_quotas_.OnFree(segment->tenant, segment->Size());
+        if (record.has_right_part) {
+            Iterator rightPart = std::next(segment);
+            RemoveFreeSegment(rightPart);
+            segment->right = rightPart->right;
+            memory_segments_.erase(rightPart);
+        }
+        if (record.has_left_part) {
+            Iterator leftPart = std::prev(segment);
+            RemoveFreeSegment(leftPart);
+            segment->left = leftPart->left;
+            memory_segments_.erase(leftPart);
+        }
+        segment->tenant = kDefaultTenant;
+        AddFreeSegment(segment);
+    }
+
+    //   TenantId     
+    //  ,      .
+    bool AdmitTenant(TenantId tenant, size_t size) {
+        TenantQuotas::CheckTenant(tenant);
+        if (tenant_quotas_.CanAllocate(tenant, size)) {
+            return true;
+        }
+        tenant_quotas_.OnReject(tenant);
+        return false;
+    }
+
+    void EnableAddressIndex() {
+        if (address_index_enabled_) {
+            return;
+        }
+        address_index_enabled_ = true;
+        for (Iterator segment = memory_segments_.begin();
+             segment != memory_segments_.end(); ++segment) {
+            if (segment->heap_index != MemorySegmentHeap::kNullIndex) {
+                free_segments_by_address_.Insert(segment);
+            }
+        }
+    }
+
+    void EnablePositionIndex() {
+        if (position_index_enabled_) {
+            return;
+        }
+        position_index_enabled_ = true;
+        for (Iterator segment = memory_segments_.begin();
+             segment != memory_segments_.end(); ++segment) {
+            if (segment->heap_index == MemorySegmentHeap::kNullIndex) {
+                allocated_segments_.Insert(segment->left, segment);
+            }
+        }
+    }
+
+    void AddFreeSegment(Iterator segment) {
+        free_memory_segments_.push(segment);
+        if (address_index_enabled_) {
+            free_segments_by_address_.Insert(segment);
+        }
+    }
+
+    void RemoveFreeSegment(Iterator segment) {
+        free_memory_segments_.erase(segment->heap_index);
+        if (address_index_enabled_) {
+            free_segments_by_address_.Erase(segment->left);
+        }
+    }
+
+    void AppendIfFree(Iterator remaining, Iterator appending) {
+        if (appending->heap_index != MemorySegmentHeap::kNullIndex) {
+            MemorySegment augmentedSegment = remaining->Unite(*appending);
+            *remaining = augmentedSegment;
+            RemoveFreeSegment(appending);
+            memory_segments_.erase(appending);
+        }
+    }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "memory_manager/memory_manager.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+/*
+*  -      ;   
+*     .
+*/
+using ArenaId = uint32_t;
+
+constexpr ArenaId kDefaultArena = 0;
+
+struct AllocationQuery {
+    size_t allocation_size;
+    TenantId tenant = kDefaultTenant;
+    ArenaId arena = kDefaultArena;
+};
+
+struct FreeQuery {
+    int allocation_query_index;
+};
+
+/*
+*      -
+* MemoryManagerQuery.      std::variant, 
+*          
+*    .    
+*  (GetType),      switch
+*  RTTI;  AsAllocationQuery  AsFreeQuery  nullptr,
+*    .
+*/
+
+class MemoryManagerQuery {
+public:
+    enum class Type {
+        kAllocation,
+        kFree
+    };
+
+    explicit MemoryManagerQuery(AllocationQuery allocation_query) :
+        query_(allocation_query) {}
+
+    explicit MemoryManagerQuery(FreeQuery free_query) :
+        query_(free_query) {}
+
+    Type GetType() const {
+        return static_cast<Type>(query_.index());
+    }
+
+    const AllocationQuery* AsAllocationQuery() const {
+        return std::get_if<AllocationQuery>(&query_);
+    }
+
+    const FreeQuery* AsFreeQuery() const {
+        return std::get_if<FreeQuery>(&query_);
+    }
+
+private:
+    std::variant<AllocationQuery, FreeQuery> query_;
+};
+
+struct MemoryManagerAllocationResponse {
+    bool success;
+    size_t position;
+};
+
+/*
+   builder' - MakeSuccessfulAllocation 
+MakeFailedAllocation.     
+MemoryManagerAllocationResponse      .  
+ - -    (, 
+),        .
+*/
+
+inline MemoryManagerAllocationResponse MakeSuccessfulAllocation(size_t position) {
+    MemoryManagerAllocationResponse response;
+    response.success = true;
+    response.position = position;
+    return response;
+};
+
+inline MemoryManagerAllocationResponse MakeFailedAllocation() {
+    MemoryManagerAllocationResponse response;
+    response.success = false;
+    response.position = 0;
+    return response;
+}
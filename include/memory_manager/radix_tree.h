@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/*
+*   (radix) ,   
+*  .   ,    
+*     ,      
+*         . 
+* :          ,
+*          . 
+*   (,   )    
+*   .
+*/
+
+template <class Value>
+class RadixTree {
+public:
+    static constexpr size_t kKeyBits = 32;
+
+    const Value* Find(size_t key) const {
+        const Leaf* leaf = FindLeaf(key);
+        if (leaf == nullptr || !leaf->Contains(LeafIndex(key))) {
+            return nullptr;
+        }
+        return &leaf->values[leaf->Rank(LeafIndex(key))];
+    }
+
+    Value* Find(size_t key) {
+        const RadixTree& self = *this;
+        return const_cast<Value*>(self.Find(key));
+    }
+
+    void Insert(size_t key, const Value& value) {
+        if (key >> kKeyBits != 0) {
+            throw std::out_of_range("RadixTree key is too large");
+        }
+        Leaf& leaf = GetOrCreate(
+            GetOrCreate(GetOrCreate(root_, key, kLeafBits + 2 * kInteriorBits),
+                key, kLeafBits + kInteriorBits),
+            key, kLeafBits);
+        const size_t index = LeafIndex(key);
+        const size_t rank = leaf.Rank(index);
+        if (leaf.Contains(index)) {
+            leaf.values[rank] = value;
+            return;
+        }
+        leaf.present |= uint64_t(1) << index;
+        leaf.values.insert(leaf.values.begin() + rank, value);
+        ++size_;
+    }
+
+    void Erase(size_t key) {
+        Leaf* leaf = const_cast<Leaf*>(FindLeaf(key));
+        if (leaf != nullptr && leaf->Contains(LeafIndex(key))) {
+            leaf->values.erase(leaf->values.begin() + leaf->Rank(LeafIndex(key)));
+            leaf->present &= ~(uint64_t(1) << LeafIndex(key));
+            --size_;
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    static constexpr size_t kLeafBits = 6;
+    static constexpr size_t kInteriorBits = 9;
+    static constexpr size_t kRootBits = kKeyBits - kLeafBits - 2 * kInteriorBits;
+
+    struct Leaf {
+        uint64_t present = 0;
+        std::vector<Value> values;
+
+        bool Contains(size_t index) const {
+            return (present >> index & 1) != 0;
+        }
+
+        size_t Rank(size_t index) const {
+            return __builtin_popcountll(present & ((uint64_t(1) << index) - 1));
+        }
+    };
+
+    template <class Child, size_t kBits>
+    struct Interior {
+        std::array<std::unique_ptr<Child>, 1 << kBits> children;
+    };
+
+    using LowerInterior = Interior<Leaf, kInteriorBits>;
+    using UpperInterior = Interior<LowerInterior, kInteriorBits>;
+    using Root = Interior<UpperInterior, kRootBits>;
+
+    Root root_;
+    size_t size_ = 0;
+
+    static size_t LeafIndex(size_t key) {
+        return key & ((1 << kLeafBits) - 1);
+    }
+
+    template <class Child, size_t kBits>
+    static Child& GetOrCreate(Interior<Child, kBits>& node, size_t key, size_t shift) {
+        std::unique_ptr<Child>& child = node.children[(key >> shift) & ((1 << kBits) - 1)];
+        if (!child) {
+            child.reset(new Child());
+        }
+        return *child;
+    }
+
+    template <class Child, size_t kBits>
+    static const Child* FindChild(const Interior<Child, kBits>* node, size_t key, size_t shift) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        return node->children[(key >> shift) & ((1 << kBits) - 1)].get();
+    }
+
+    const Leaf* FindLeaf(size_t key) const {
+        if (key >> kKeyBits != 0) {
+            return nullptr;
+        }
+        return FindChild(FindChild(FindChild(&root_, key, kLeafBits + 2 * kInteriorBits),
+            key, kLeafBits + kInteriorBits), key, kLeafBits);
+    }
+};
@@ -0,0 +1,647 @@
+#pragma once
+
+#include "memory_manager/bitmap_memory_manager.h"
+#include "memory_manager/memory_manager.h"
+#include "memory_manager/query.h"
+#include "memory_manager/slab_memory_manager.h"
+#include "memory_manager/trace_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class MemoryManagerEngine {
+    kSegmentList,
+    kBitmap,
+    kSlab
+};
+
+/*
+*       ,     
+*  :   -  ,  Free 
+*    ,   - .
+*/
+inline MemoryManager::Iterator AllocateInEngine(MemoryManager& memory,
+    const AllocationQuery& query) {
+    return memory.Allocate(query.allocation_size, query.tenant);
+}
+
+inline size_t AllocateInEngine(BitmapMemoryManager& memory, const AllocationQuery& query) {
+    return memory.Allocate(query.allocation_size);
+}
+
+inline size_t AllocateInEngine(SlabMemoryManager& memory, const AllocationQuery& query) {
+    return memory.Allocate(query.allocation_size);
+}
+
+template <class Memory>
+using EngineAllocation = decltype(AllocateInEngine(std::declval<Memory&>(),
+    std::declval<const AllocationQuery&>()));
+
+//    ; kNullPosition,    .
+inline size_t AllocationPosition(MemoryManager& memory, MemoryManager::Iterator segment) {
+    return segment == memory.end() ? MemoryManager::kNullPosition : segment->left;
+}
+
+template <class Memory>
+size_t AllocationPosition(Memory&, size_t position) {
+    return position;
+}
+
+using AllocationHandle = uint32_t;
+
+/*
+*   :      
+* (),     32-  -  .
+*        ,  
+*        .
+*/
+
+template <class Allocation>
+class AllocationHandleTable {
+public:
+    using Handle = AllocationHandle;
+
+    Handle Insert(Allocation allocation) {
+        if (!free_handles_.empty()) {
+            const Handle handle = free_handles_.back();
+            free_handles_.pop_back();
+            allocations_[handle] = allocation;
+            return handle;
+        }
+        if (allocations_.size() == kNoHandle) {
+            throw std::runtime_error("Too many live allocations");
+        }
+        allocations_.push_back(allocation);
+        return static_cast<Handle>(allocations_.size() - 1);
+    }
+
+    //     .
+    Allocation Release(Handle handle) {
+        free_handles_.push_back(handle);
+        return allocations_[handle];
+    }
+
+private:
+    static constexpr Handle kNoHandle = UINT32_MAX;
+
+    std::vector<Allocation> allocations_;
+    std::vector<Handle> free_handles_;
+};
+
+/*
+*       .  
+*         64.  
+* ,     ,    
+*   ,        .
+*        ,  
+*  ,    . ,   
+* ,  ,      
+* ,       -     . 
+*    ,    trace',  
+*      .
+*/
+
+class QueryHandleMap {
+public:
+    using Handle = AllocationHandle;
+
+    void Insert(size_t query_index, Handle handle) {
+        const size_t block_index = query_index >> kBlockBits;
+        if (open_block_.index != block_index) {
+            SealOpenBlock();
+            open_block_.index = block_index;
+        }
+        const uint64_t bit = uint64_t(1) << (query_index & kBlockMask);
+        open_block_.stored |= bit;
+        open_block_.live |= bit;
+        open_handles_.push_back(handle);
+    }
+
+    //    query_index; false,   .
+    bool Extract(size_t query_index, Handle* handle) {
+        const size_t block_index = query_index >> kBlockBits;
+        const uint64_t bit = uint64_t(1) << (query_index & kBlockMask);
+        if (block_index == open_block_.index) {
+            if ((open_block_.live & bit) == 0) {
+                return false;
+            }
+            *handle = open_handles_[__builtin_popcountll(open_block_.stored & (bit - 1))];
+            open_block_.live &= ~bit;
+            return true;
+        }
+        auto block = std::lower_bound(sealed_blocks_.begin(), sealed_blocks_.end(), block_index,
+            [](const Block& block, size_t index) {
+                return block.index < index;
+            });
+        if (block == sealed_blocks_.end() || block->index != block_index ||
+            (block->live & bit) == 0) {
+            return false;
+        }
+        *handle = block->handles[__builtin_popcountll(block->stored & (bit - 1))];
+        block->live &= ~bit;
+        if (block->live == 0) {
+            block->handles.reset();
+            ++dead_blocks_;
+            if (dead_blocks_ * 2 > sealed_blocks_.size()) {
+                sealed_blocks_.erase(std::remove_if(sealed_blocks_.begin(), sealed_blocks_.end(),
+                    [](const Block& block) {
+                        return block.live == 0;
+                    }), sealed_blocks_.end());
+                dead_blocks_ = 0;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kBlockBits = 6;
+    static constexpr size_t kBlockMask = (1 << kBlockBits) - 1;
+    static constexpr size_t kNoBlock = static_cast<size_t>(-1);
+
+    struct Block {
+        size_t index = kNoBlock;
+        uint64_t stored = 0;
+        uint64_t live = 0;
+        std::unique_ptr<Handle[]> handles;
+    };
+
+    std::vector<Block> sealed_blocks_;
+    size_t dead_blocks_ = 0;
+    Block open_block_;
+    std::vector<Handle> open_handles_;
+
+    void SealOpenBlock() {
+        if (open_block_.live != 0) {
+            open_block_.handles.reset(new Handle[open_handles_.size()]);
+            std::copy(open_handles_.begin(), open_handles_.end(), open_block_.handles.get());
+            sealed_blocks_.push_back(std::move(open_block_));
+        }
+        open_block_ = Block();
+        open_handles_.clear();
+    }
+};
+
+template <class Memory>
+std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
+    Memory& memory, const std::vector<MemoryManagerQuery>& queries) {
+
+    std::vector<MemoryManagerAllocationResponse> responses;
+    responses.reserve(std::count_if(queries.begin(), queries.end(),
+        [](const MemoryManagerQuery& query) {
+            return query.GetType() == MemoryManagerQuery::Type::kAllocation;
+        }));
+    AllocationHandleTable<EngineAllocation<Memory>> handles;
+    QueryHandleMap query_handles;
+    for (size_t current_query = 0; current_query < queries.size(); ++current_query) {
+        const MemoryManagerQuery& query = queries[current_query];
+        switch (query.GetType()) {
+        case MemoryManagerQuery::Type::kAllocation: {
+            const EngineAllocation<Memory> allocation =
+                AllocateInEngine(memory, *query.AsAllocationQuery());
+            const size_t position = AllocationPosition(memory, allocation);
+            if (position != MemoryManager::kNullPosition) {
+                responses.push_back(MakeSuccessfulAllocation(position));
+                query_handles.Insert(current_query, handles.Insert(allocation));
+            } else {
+                responses.push_back(MakeFailedAllocation());
+            }
+            break;
+        }
+        case MemoryManagerQuery::Type::kFree: {
+            AllocationHandle handle;
+            if (query_handles.Extract(query.AsFreeQuery()->allocation_query_index - 1, &handle)) {
+                memory.Free(handles.Release(handle));
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown MemoryManagerQuery type");
+        }
+    }
+    return responses;
+}
+
+/*
+*      :    max_sizes
+* ,        min_share .
+*/
+std::vector<size_t> DetectHotSizes(const std::vector<MemoryManagerQuery>& queries,
+    size_t max_sizes = 8, double min_share = 0.05);
+
+enum class TraceFormat {
+    kNone,
+    kText,
+    kBinary
+};
+
+struct ReplayOptions {
+    MemoryManagerEngine engine = MemoryManagerEngine::kSegmentList;
+    AllocationPolicy policy = AllocationPolicy::kLargestFirst;
+    //  ;    kSegmentList.
+    std::vector<std::pair<TenantId, TenantLimits>> tenant_limits;
+    //       .
+    std::vector<size_t> hot_sizes;
+    //    ,     . 
+    //       ,    .
+    std::string trace_path;
+    //     ,    trace  .
+    bool stream = false;
+    // ,        .
+    bool pipeline = false;
+    //         io_uring.
+    bool io_uring = false;
+    //   - trace'   .
+    std::string batch_path;
+    std::string output_dir;
+    //       ; 0 -   .
+    //      trace':    
+    // threads_count   1.
+    size_t threads_count = 0;
+    //  Unix-,     (--daemon)   
+    //    (--load-test),    .
+    std::string daemon_socket;
+    std::string load_test_socket;
+    size_t memory_size = 0;
+    //          ;
+    //        shm_open ("/name").
+    bool shared_memory = false;
+    //   :  ,    
+    //   .
+    size_t load_clients = 4;
+    size_t load_requests = 100000;
+    size_t load_max_size = 64;
+    //   , trace  ,    convert_path.
+    TraceFormat convert_format = TraceFormat::kNone;
+    std::string convert_path;
+};
+
+/*
+*    options      action. hot_sizes
+*    kSlab.
+*/
+template <class Action>
+void VisitMemoryEngine(size_t memory_size, const ReplayOptions& options,
+    const std::vector<size_t>& hot_sizes, Action action) {
+
+    switch (options.engine) {
+    case MemoryManagerEngine::kSegmentList: {
+        MemoryManager memory(memory_size, options.policy);
+        for (const auto& tenant_limits : options.tenant_limits) {
+            memory.SetTenantLimits(tenant_limits.first, tenant_limits.second);
+        }
+        action(memory);
+        return;
+    }
+    case MemoryManagerEngine::kBitmap: {
+        BitmapMemoryManager memory(memory_size);
+        action(memory);
+        return;
+    }
+    case MemoryManagerEngine::kSlab: {
+        SlabMemoryManager memory(memory_size, hot_sizes);
+        action(memory);
+        return;
+    }
+    }
+    throw std::runtime_error("Unknown MemoryManagerEngine");
+}
+
+std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    const ReplayOptions& options = ReplayOptions());
+
+/*
+*  trace   :     
+*   memory_size.     (
+*    ),  
+*     options.threads_count  (   -
+*    ),   
+*     . Trace     .
+*/
+std::vector<MemoryManagerAllocationResponse> RunArenaMemoryManagers(
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    const ReplayOptions& options = ReplayOptions());
+
+/*
+*        .   
+*    AllocationHandleTable  QueryHandleMap,  
+*     ,    trace'.
+*/
+template <class Memory>
+class IncrementalReplay {
+public:
+    explicit IncrementalReplay(Memory& memory) :
+        memory_(memory),
+        query_index_(0) {}
+
+    //   ,   ,    response.
+    bool Execute(const MemoryManagerQuery& query, MemoryManagerAllocationResponse* response) {
+        ++query_index_;
+        switch (query.GetType()) {
+        case MemoryManagerQuery::Type::kAllocation: {
+            if (query.AsAllocationQuery()->arena != kDefaultArena) {
+                throw std::runtime_error("Arenas are not supported in stream and pipeline modes");
+            }
+            const EngineAllocation<Memory> allocation =
+                AllocateInEngine(memory_, *query.AsAllocationQuery());
+            const size_t position = AllocationPosition(memory_, allocation);
+            if (position != MemoryManager::kNullPosition) {
+                query_handles_.Insert(query_index_ - 1, handles_.Insert(allocation));
+                *response = MakeSuccessfulAllocation(position);
+            } else {
+                *response = MakeFailedAllocation();
+            }
+            return true;
+        }
+        case MemoryManagerQuery::Type::kFree: {
+            AllocationHandle handle;
+            if (query_handles_.Extract(query.AsFreeQuery()->allocation_query_index - 1, &handle)) {
+                memory_.Free(handles_.Release(handle));
+            }
+            return false;
+        }
+        default:
+            throw std::runtime_error("Unknown MemoryManagerQuery type");
+        }
+    }
+
+private:
+    Memory& memory_;
+    AllocationHandleTable<EngineAllocation<Memory>> handles_;
+    QueryHandleMap query_handles_;
+    size_t query_index_;
+};
+
+/*
+*  :      ,  
+*    .
+*/
+template <class Memory, class TraceReader>
+void StreamMemoryManager(Memory& memory, TraceReader& trace, std::ostream& ostream) {
+    FastOutputWriter writer(ostream);
+    IncrementalReplay<Memory> replay(memory);
+    std::optional<MemoryManagerQuery> query;
+    MemoryManagerAllocationResponse response;
+    while (trace.ReadQuery(&query)) {
+        if (query && replay.Execute(*query, &response)) {
+            OutputMemoryManagerResponse(response, writer);
+        }
+    }
+    writer.WriteChar('\n');
+}
+
+/*
+*    trace   ,   
+*   kSlab    .
+*/
+template <class TraceReader>
+void StreamTrace(TraceReader& trace, std::ostream& ostream,
+    const ReplayOptions& options = ReplayOptions()) {
+    VisitMemoryEngine(trace.MemorySize(), options, options.hot_sizes, [&](auto& memory) {
+        StreamMemoryManager(memory, trace, ostream);
+    });
+}
+
+/*
+*          .
+*    tail_,  -  head_;   
+*  -,      .
+*/
+
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t rounded_capacity = 1;
+        while (rounded_capacity < capacity) {
+            rounded_capacity *= 2;
+        }
+        slots_.resize(rounded_capacity);
+    }
+
+    //    value  .
+    bool TryPush(T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return false;
+        }
+        slots_[tail & (slots_.size() - 1)] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T* value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *value = std::move(slots_[head & (slots_.size() - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //    ;  false,   .
+    bool Push(T& value, const std::atomic<bool>& cancelled) {
+        while (!TryPush(value)) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    //    ;  false,   .
+    bool Pop(T* value, const std::atomic<bool>& cancelled) {
+        while (!TryPop(value)) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+};
+
+/*
+*     :  trace',   
+*  .       
+*  ;     kPipelineBatchSize
+*  ()  SpscRing,      .
+*          
+*  PipelineTrace   .
+*/
+
+constexpr size_t kPipelineBatchSize = 4096;
+constexpr size_t kPipelineRingCapacity = 64;
+
+template <class TraceReader>
+void PipelineTrace(TraceReader& trace, std::ostream& ostream,
+    const ReplayOptions& options = ReplayOptions()) {
+    using QueryBatch = std::vector<MemoryManagerQuery>;
+    using ResponseBatch = std::vector<MemoryManagerAllocationResponse>;
+
+    SpscRing<QueryBatch> query_batches(kPipelineRingCapacity);
+    SpscRing<ResponseBatch> response_batches(kPipelineRingCapacity);
+    std::atomic<bool> cancelled(false);
+    std::exception_ptr parser_error;
+    std::exception_ptr executor_error;
+    std::exception_ptr writer_error;
+
+    std::thread parser([&] {
+        try {
+            QueryBatch batch;
+            std::optional<MemoryManagerQuery> query;
+            while (trace.ReadQuery(&query)) {
+                if (query) {
+                    batch.push_back(*query);
+                }
+                if (batch.size() == kPipelineBatchSize) {
+                    if (!query_batches.Push(batch, cancelled)) {
+                        return;
+                    }
+                    batch = QueryBatch();
+                }
+            }
+            if (!batch.empty()) {
+                query_batches.Push(batch, cancelled);
+            }
+        } catch (...) {
+            parser_error = std::current_exception();
+        }
+        QueryBatch end_of_trace;
+        query_batches.Push(end_of_trace, cancelled);
+    });
+
+    std::thread writer([&] {
+        try {
+            FastOutputWriter output_writer(ostream);
+            ResponseBatch batch;
+            while (response_batches.Pop(&batch, cancelled) && !batch.empty()) {
+                for (const MemoryManagerAllocationResponse& response : batch) {
+                    OutputMemoryManagerResponse(response, output_writer);
+                }
+            }
+            output_writer.WriteChar('\n');
+        } catch (...) {
+            writer_error = std::current_exception();
+            cancelled = true;
+        }
+    });
+
+    try {
+        VisitMemoryEngine(trace.MemorySize(), options, options.hot_sizes, [&](auto& memory) {
+            IncrementalReplay<std::decay_t<decltype(memory)>> replay(memory);
+            QueryBatch batch;
+            MemoryManagerAllocationResponse response;
+            while (query_batches.Pop(&batch, cancelled) && !batch.empty()) {
+                ResponseBatch responses;
+                responses.reserve(batch.size());
+                for (const MemoryManagerQuery& query : batch) {
+                    if (replay.Execute(query, &response)) {
+                        responses.push_back(response);
+                    }
+                }
+                if (!responses.empty() && !response_batches.Push(responses, cancelled)) {
+                    return;
+                }
+            }
+        });
+    } catch (...) {
+        executor_error = std::current_exception();
+        cancelled = true;
+    }
+    ResponseBatch end_of_responses;
+    response_batches.Push(end_of_responses, cancelled);
+    parser.join();
+    writer.join();
+    for (const std::exception_ptr& error : { parser_error, executor_error, writer_error }) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/*
+*  trace    options : , ,
+*         .
+*/
+template <class TraceReader>
+void ReplayTrace(TraceReader& trace, std::ostream& ostream, const ReplayOptions& options) {
+    if (options.pipeline) {
+        PipelineTrace(trace, ostream, options);
+        return;
+    }
+    if (options.stream) {
+        StreamTrace(trace, ostream, options);
+        return;
+    }
+    const std::vector<MemoryManagerQuery> queries = ReadTraceQueries(trace);
+    if (options.convert_format != TraceFormat::kNone) {
+        std::ofstream converted(options.convert_path, std::ios::binary);
+        if (!converted) {
+            throw std::runtime_error("Cannot create " + options.convert_path);
+        }
+        if (options.convert_format == TraceFormat::kBinary) {
+            WriteBinaryTrace(trace.MemorySize(), queries, converted);
+        } else {
+            WriteTextTrace(trace.MemorySize(), queries, converted);
+        }
+        return;
+    }
+    const std::vector<MemoryManagerAllocationResponse> responses =
+        RunArenaMemoryManagers(trace.MemorySize(), queries, options);
+    OutputMemoryManagerResponses(responses, ostream);
+}
+
+/*
+*  trace,    input_reader ( ,
+* ),     :  trace  
+* kBinaryTraceMagic,     .
+*/
+void ReplayTraceStream(FastInputReader& input_reader, std::ostream& ostream,
+    const ReplayOptions& options);
+
+/*
+*  trace       ,  
+* (  )  .
+*/
+void ReplayTraceFile(const std::string& path, std::ostream& ostream, const ReplayOptions& options);
+
+/*
+*  :  trace    - (  
+* )   MemoryManager   ,   
+*  .   trace NAME   output_dir/NAME.out
+* (   - -  NAME.2.out, NAME.3.out, ...),  
+*   trace' -  output_dir/timings.tsv.
+*  false,     trace   .
+*/
+bool RunBatchReplay(const ReplayOptions& options);
+
+/*
+*  trace   -: trace   
+*     AsyncFileReader,    
+*    AsyncFileWriter. Trace   -
+*   .
+*/
+void ReplayWithAsyncIo(const ReplayOptions& options);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "memory_manager/memory_manager.h"
+#include "memory_manager/radix_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/*
+* Slab-  MemoryManager  ""  . 
+*       MemoryManager  slab 
+* kObjectsPerSlab         
+*  ,   . Slab'     
+*     partial_slabs  ,  
+*  slab    MemoryManager.  slab 
+*  ,   MemoryManager' .
+*/
+
+class SlabMemoryManager {
+public:
+    static constexpr size_t kNullPosition = MemoryManager::kNullPosition;
+    static constexpr size_t kObjectsPerSlab = 64;
+
+    SlabMemoryManager(size_t memory_size, const std::vector<size_t>& hot_sizes) :
+        memory_(memory_size) {
+        for (size_t size : hot_sizes) {
+            if (size != 0) {
+                size_classes_[size];
+            }
+        }
+    }
+
+    size_t Allocate(size_t size) {
+        auto size_class = size_classes_.find(size);
+        if (size_class == size_classes_.end()) {
+            return AllocateDirect(size);
+        }
+        std::vector<uint32_t>& partial_slabs = size_class->second.partial_slabs;
+        if (partial_slabs.empty() && !CreateSlab(size, &partial_slabs)) {
+            return AllocateDirect(size);
+        }
+        const uint32_t slab_id = partial_slabs.back();
+        Slab& slab = slabs_[slab_id];
+        const size_t object = __builtin_ctzll(slab.free_objects);
+        slab.free_objects &= slab.free_objects - 1;
+        if (slab.free_objects == 0) {
+            RemovePartialSlab(slab_id, &partial_slabs);
+        }
+        const size_t position = slab.position + object * slab.object_size;
+        slab_objects_.Insert(position, slab_id);
+        return position;
+    }
+
+    void Free(size_t position) {
+        const uint32_t* slab_id_pointer = slab_objects_.Find(position);
+        if (slab_id_pointer == nullptr) {
+            memory_.Free(position);
+            return;
+        }
+        const uint32_t slab_id = *slab_id_pointer;
+        slab_objects_.Erase(position);
+        Slab& slab = slabs_[slab_id];
+        std::vector<uint32_t>& partial_slabs =
+            size_classes_[slab.object_size].partial_slabs;
+        if (slab.free_objects == 0) {
+            slab.partial_index = partial_slabs.size();
+            partial_slabs.push_back(slab_id);
+        }
+        slab.free_objects |= uint64_t(1) << ((position - slab.position) / slab.object_size);
+        if (slab.free_objects == kAllObjectsFree) {
+            RemovePartialSlab(slab_id, &partial_slabs);
+            memory_.Free(slab.position);
+            free_slab_ids_.push_back(slab_id);
+        }
+    }
+
+private:
+    static constexpr uint64_t kAllObjectsFree = ~uint64_t(0);
+    static constexpr size_t kNotPartial = static_cast<size_t>(-1);
+
+    struct Slab {
+        size_t position;
+        size_t object_size;
+        uint64_t free_objects;
+        size_t partial_index;
+    };
+
+    struct SizeClass {
+        std::vector<uint32_t> partial_slabs;
+    };
+
+    MemoryManager memory_;
+    std::unordered_map<size_t, SizeClass> size_classes_;
+    std::vector<Slab> slabs_;
+    std::vector<uint32_t> free_slab_ids_;
+    RadixTree<uint32_t> slab_objects_;
+
+    size_t AllocateDirect(size_t size) {
+        MemoryManager::Iterator segment = memory_.Allocate(size);
+        if (segment == memory_.end()) {
+            return kNullPosition;
+        }
+        return segment->left;
+    }
+
+    bool CreateSlab(size_t object_size, std::vector<uint32_t>* partial_slabs) {
+        const size_t position = AllocateDirect(object_size * kObjectsPerSlab);
+        if (position == kNullPosition) {
+            return false;
+        }
+        uint32_t slab_id;
+        if (free_slab_ids_.empty()) {
+            slab_id = slabs_.size();
+            slabs_.emplace_back();
+        } else {
+            slab_id = free_slab_ids_.back();
+            free_slab_ids_.pop_back();
+        }
+        slabs_[slab_id] = Slab{ position, object_size, kAllObjectsFree, partial_slabs->size() };
+        partial_slabs->push_back(slab_id);
+        return true;
+    }
+
+    void RemovePartialSlab(uint32_t slab_id, std::vector<uint32_t>* partial_slabs) {
+        const size_t index = slabs_[slab_id].partial_index;
+        slabs_[partial_slabs->back()].partial_index = index;
+        (*partial_slabs)[index] = partial_slabs->back();
+        partial_slabs->pop_back();
+        slabs_[slab_id].partial_index = kNotPartial;
+    }
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+*      (work stealing):    
+*  , Submit      .  
+*     ,     -   
+* ,    ,     .
+*/
+
+class WorkStealingThreadPool {
+public:
+    explicit WorkStealingThreadPool(size_t threads_count) :
+        next_queue_(0),
+        queued_(0),
+        pending_(0),
+        stopping_(false) {
+        threads_count = std::max<size_t>(threads_count, 1);
+        for (size_t worker = 0; worker < threads_count; ++worker) {
+            queues_.emplace_back(new WorkerQueue());
+        }
+        for (size_t worker = 0; worker < threads_count; ++worker) {
+            threads_.emplace_back([this, worker] { WorkerLoop(worker); });
+        }
+    }
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    ~WorkStealingThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void Submit(std::function<void()> task) {
+        WorkerQueue& queue = *queues_[next_queue_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            ++queued_;
+            ++pending_;
+        }
+        work_available_.notify_one();
+    }
+
+    //     .
+    void Wait() {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        all_done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    size_t next_queue_;
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    size_t queued_;
+    size_t pending_;
+    bool stopping_;
+
+    bool TryTake(size_t worker, std::function<void()>* task) {
+        for (size_t offset = 0; offset < queues_.size(); ++offset) {
+            WorkerQueue& queue = *queues_[(worker + offset) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (offset == 0) {
+                *task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                *task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerLoop(size_t worker) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(state_mutex_);
+                work_available_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+                if (queued_ == 0) {
+                    return;
+                }
+                --queued_;
+            }
+            std::function<void()> task;
+            while (!TryTake(worker, &task)) {
+                std::this_thread::yield();
+            }
+            task();
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            if (--pending_ == 0) {
+                all_done_.notify_all();
+            }
+        }
+    }
+};
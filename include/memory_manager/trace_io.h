@@ -0,0 +1,506 @@
+#pragma once
+
+#include "memory_manager/async_io.h"
+#include "memory_manager/query.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+*      std::istream:   
+*   buffer_size   fread,    std::from_chars
+*   .       
+*     kMaxTokenLength ,     
+*  .         
+*  (,  ) -    
+*   ,   AsyncFileReader  fread.
+*/
+
+class FastInputReader {
+public:
+    explicit FastInputReader(std::FILE* file, size_t buffer_size = 1 << 20) :
+        file_(file),
+        async_file_(nullptr),
+        buffer_(buffer_size),
+        current_(buffer_.data()),
+        end_(buffer_.data()),
+        eof_(false) {}
+
+    explicit FastInputReader(AsyncFileReader* file, size_t buffer_size = 1 << 20) :
+        file_(nullptr),
+        async_file_(file),
+        buffer_(buffer_size),
+        current_(buffer_.data()),
+        end_(buffer_.data()),
+        eof_(false) {}
+
+    FastInputReader(const char* begin, const char* end) :
+        file_(nullptr),
+        async_file_(nullptr),
+        current_(begin),
+        end_(end),
+        eof_(true) {}
+
+    //         .
+    //  false,    .
+    template <class Integer>
+    bool ReadInteger(Integer* value) {
+        SkipWhitespace();
+        if (current_ == end_) {
+            return false;
+        }
+        if (!eof_ && end_ - current_ < kMaxTokenLength) {
+            Refill();
+        }
+        const std::from_chars_result result = std::from_chars(current_, end_, *value);
+        if (result.ec != std::errc()) {
+            throw std::runtime_error("Invalid integer in input");
+        }
+        current_ = result.ptr;
+        return true;
+    }
+
+    //        EOF.
+    int ReadByte() {
+        if (current_ == end_) {
+            Refill();
+        }
+        return current_ == end_ ? EOF : static_cast<unsigned char>(*current_++);
+    }
+
+    // ,      prefix,  
+    // .  prefix   kMaxTokenLength.
+    bool StartsWith(const char* prefix, size_t length) {
+        if (end_ - current_ < static_cast<ptrdiff_t>(length)) {
+            Refill();
+        }
+        return end_ - current_ >= static_cast<ptrdiff_t>(length) &&
+            std::memcmp(current_, prefix, length) == 0;
+    }
+
+    //   ,   ,  EOF.
+    int Peek() {
+        if (current_ == end_) {
+            Refill();
+        }
+        return current_ == end_ ? EOF : static_cast<unsigned char>(*current_);
+    }
+
+    void Skip() {
+        if (Peek() != EOF) {
+            ++current_;
+        }
+    }
+
+private:
+    static constexpr ptrdiff_t kMaxTokenLength = 64;
+
+    std::FILE* file_;
+    AsyncFileReader* async_file_;
+    std::vector<char> buffer_;
+    const char* current_;
+    const char* end_;
+    bool eof_;
+
+    void SkipWhitespace() {
+        while (true) {
+            while (current_ != end_ && std::isspace(static_cast<unsigned char>(*current_))) {
+                ++current_;
+            }
+            if (current_ != end_ || eof_) {
+                return;
+            }
+            Refill();
+        }
+    }
+
+    void Refill() {
+        if (eof_) {
+            return;
+        }
+        const size_t remaining = end_ - current_;
+        std::memmove(buffer_.data(), current_, remaining);
+        size_t filled = remaining;
+        while (!eof_ && filled < buffer_.size()) {
+            const size_t read = async_file_ != nullptr ?
+                async_file_->Read(buffer_.data() + filled, buffer_.size() - filled) :
+                std::fread(buffer_.data() + filled, 1, buffer_.size() - filled, file_);
+            if (read == 0) {
+                eof_ = true;
+            }
+            filled += read;
+            if (static_cast<ptrdiff_t>(filled) >= kMaxTokenLength) {
+                break;
+            }
+        }
+        current_ = buffer_.data();
+        end_ = buffer_.data() + filled;
+    }
+};
+
+/*
+* ,      .  ,  
+*    (MADV_SEQUENTIAL),  
+*   ,       .
+*/
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) :
+        data_(nullptr),
+        size_(0) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        size_ = file_stat.st_size;
+        if (size_ != 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    const char* begin() const {
+        return data_;
+    }
+
+    const char* end() const {
+        return data_ + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+size_t ReadMemorySize(std::istream& stream = std::cin);
+
+size_t ReadMemorySize(FastInputReader& reader);
+
+/*
+*        "size:tenant",  
+*   tenant;   -  kDefaultTenant.
+*  "@arena" (, "size@arena"  "size:tenant@arena") 
+*    arena,   -  kDefaultArena. 
+*    ,   .
+*/
+std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(std::istream& stream = std::cin);
+
+/*
+*   reader  .   ,   
+*   std::istream,  query  .  false, 
+*   .
+*/
+inline bool ReadMemoryManagerQuery(FastInputReader& reader, std::optional<MemoryManagerQuery>* query) {
+    query->reset();
+    int abstract_query = 0;
+    if (!reader.ReadInteger(&abstract_query)) {
+        return false;
+    }
+    if (abstract_query > 0) {
+        AllocationQuery allocation_query{ static_cast<size_t>(abstract_query) };
+        if (reader.Peek() == ':') {
+            reader.Skip();
+            reader.ReadInteger(&allocation_query.tenant);
+        }
+        if (reader.Peek() == '@') {
+            reader.Skip();
+            reader.ReadInteger(&allocation_query.arena);
+        }
+        query->emplace(allocation_query);
+    }
+    if (abstract_query < 0) {
+        query->emplace(FreeQuery{ -abstract_query });
+    }
+    return true;
+}
+
+std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(FastInputReader& reader);
+
+/*
+*   FastInputReader,  trace   : 
+* ,     .
+*/
+
+class TextTraceReader {
+public:
+    explicit TextTraceReader(FastInputReader& reader) :
+        reader_(reader),
+        memory_size_(ReadMemorySize(reader)),
+        queries_count_(0),
+        read_queries_(0) {
+        if (!reader_.ReadInteger(&queries_count_)) {
+            throw std::runtime_error("Missing queries count in trace");
+        }
+    }
+
+    size_t MemorySize() const {
+        return memory_size_;
+    }
+
+    size_t QueriesCount() const {
+        return queries_count_;
+    }
+
+    bool ReadQuery(std::optional<MemoryManagerQuery>* query) {
+        if (read_queries_ == queries_count_) {
+            return false;
+        }
+        ++read_queries_;
+        return ReadMemoryManagerQuery(reader_, query);
+    }
+
+private:
+    FastInputReader& reader_;
+    size_t memory_size_;
+    size_t queries_count_;
+    size_t read_queries_;
+};
+
+/*
+*    trace'. :  kBinaryTraceMagic,
+* , ,  varint'     .  
+* - zigzag-varint:      
+* ( ,    kBinaryTraceHasTenants,  varint
+* ,     kBinaryTraceHasArenas - varint ),
+*  -d -  ,  d
+*   .    .
+*/
+
+constexpr char kBinaryTraceMagic[4] = { 'M', 'M', 'T', 'B' };
+constexpr uint8_t kBinaryTraceVersion = 1;
+constexpr uint8_t kBinaryTraceHasTenants = 1;
+constexpr uint8_t kBinaryTraceHasArenas = 2;
+
+bool IsBinaryTrace(const char* begin, const char* end);
+
+class BinaryTraceReader {
+public:
+    //  trace  reader,    .
+    explicit BinaryTraceReader(FastInputReader& reader) :
+        reader_(reader),
+        read_queries_(0) {
+        ReadHeader();
+    }
+
+    //  trace        .
+    BinaryTraceReader(const char* begin, const char* end) :
+        memory_reader_(std::in_place, begin, end),
+        reader_(*memory_reader_),
+        read_queries_(0) {
+        ReadHeader();
+    }
+
+    size_t MemorySize() const {
+        return memory_size_;
+    }
+
+    size_t QueriesCount() const {
+        return queries_count_;
+    }
+
+    bool ReadQuery(std::optional<MemoryManagerQuery>* query) {
+        if (read_queries_ == queries_count_) {
+            return false;
+        }
+        ++read_queries_;
+        const uint64_t encoded = ReadVarint();
+        const int64_t value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+        if (value > 0) {
+            AllocationQuery allocation_query{ static_cast<size_t>(value) };
+            if (flags_ & kBinaryTraceHasTenants) {
+                const uint64_t tenant = ReadVarint();
+                if (tenant >= TenantQuotas::kMaxTenants) {
+                    throw std::runtime_error("Tenant id is out of range in binary trace");
+                }
+                allocation_query.tenant = static_cast<TenantId>(tenant);
+            }
+            if (flags_ & kBinaryTraceHasArenas) {
+                const uint64_t arena = ReadVarint();
+                if (arena > std::numeric_limits<ArenaId>::max()) {
+                    throw std::runtime_error("Arena id is out of range in binary trace");
+                }
+                allocation_query.arena = static_cast<ArenaId>(arena);
+            }
+            query->emplace(allocation_query);
+        } else if (value < 0) {
+            query->emplace(FreeQuery{ static_cast<int>(read_queries_ + value) });
+        } else {
+            query->reset();
+        }
+        return true;
+    }
+
+private:
+    std::optional<FastInputReader> memory_reader_;
+    FastInputReader& reader_;
+    uint8_t flags_;
+    size_t memory_size_;
+    size_t queries_count_;
+    size_t read_queries_;
+
+    void ReadHeader() {
+        if (!reader_.StartsWith(kBinaryTraceMagic, sizeof(kBinaryTraceMagic))) {
+            throw std::runtime_error("Invalid binary trace header");
+        }
+        for (size_t current_byte = 0; current_byte < sizeof(kBinaryTraceMagic); ++current_byte) {
+            reader_.ReadByte();
+        }
+        if (ReadByte() != kBinaryTraceVersion) {
+            throw std::runtime_error("Unsupported binary trace version");
+        }
+        flags_ = ReadByte();
+        memory_size_ = ReadVarint();
+        queries_count_ = ReadVarint();
+    }
+
+    uint8_t ReadByte() {
+        const int byte = reader_.ReadByte();
+        if (byte == EOF) {
+            throw std::runtime_error("Truncated binary trace");
+        }
+        return static_cast<uint8_t>(byte);
+    }
+
+    uint64_t ReadVarint() {
+        uint64_t value = 0;
+        for (size_t shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = ReadByte();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid varint in binary trace");
+    }
+};
+
+template <class TraceReader>
+std::vector<MemoryManagerQuery> ReadTraceQueries(TraceReader& trace) {
+    std::vector<MemoryManagerQuery> queries;
+    queries.reserve(trace.QueriesCount());
+    std::optional<MemoryManagerQuery> query;
+    while (trace.ReadQuery(&query)) {
+        if (query) {
+            queries.push_back(*query);
+        }
+    }
+    return queries;
+}
+
+void WriteVarint(uint64_t value, std::string* output);
+
+void WriteBinaryTrace(size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    std::ostream& ostream);
+
+void WriteTextTrace(size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    std::ostream& ostream);
+
+/*
+*    std::ostream:   std::to_chars  
+*  buffer_size,       write, 
+* ,  Flush    .
+*/
+
+class FastOutputWriter {
+public:
+    explicit FastOutputWriter(std::ostream& ostream, size_t buffer_size = 1 << 16) :
+        ostream_(ostream),
+        buffer_(std::max<size_t>(buffer_size, kMaxTokenLength)),
+        used_(0) {}
+
+    FastOutputWriter(const FastOutputWriter&) = delete;
+    FastOutputWriter& operator=(const FastOutputWriter&) = delete;
+
+    ~FastOutputWriter() {
+        Flush();
+    }
+
+    template <class Integer>
+    void WriteInteger(Integer value) {
+        Reserve(kMaxTokenLength);
+        const std::to_chars_result result =
+            std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value);
+        used_ = result.ptr - buffer_.data();
+    }
+
+    void WriteChar(char symbol) {
+        Reserve(1);
+        buffer_[used_++] = symbol;
+    }
+
+    void Flush() {
+        if (used_ != 0) {
+            ostream_.write(buffer_.data(), used_);
+            used_ = 0;
+        }
+        ostream_.flush();
+    }
+
+private:
+    static constexpr size_t kMaxTokenLength = 32;
+
+    std::ostream& ostream_;
+    std::vector<char> buffer_;
+    size_t used_;
+
+    void Reserve(size_t size) {
+        if (buffer_.size() - used_ < size) {
+            ostream_.write(buffer_.data(), used_);
+            used_ = 0;
+        }
+    }
+};
+
+inline void OutputMemoryManagerResponse(const MemoryManagerAllocationResponse& response,
+    FastOutputWriter& writer) {
+    if (response.success == true) {
+        writer.WriteInteger(response.position);
+    } else {
+        writer.WriteInteger(-1);
+    }
+    writer.WriteChar('\n');
+}
+
+void OutputMemoryManagerResponses(const std::vector<MemoryManagerAllocationResponse>& responses,
+    std::ostream& ostream = std::cout);
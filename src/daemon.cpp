@@ -0,0 +1,34 @@
+#include "memory_manager/daemon.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+volatile std::sig_atomic_t daemon_stop_requested = 0;
+
+void StopDaemonOnSignals() {
+    std::signal(SIGINT, [](int) { daemon_stop_requested = 1; });
+    std::signal(SIGTERM, [](int) { daemon_stop_requested = 1; });
+}
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, long timeout_ns) {
+    timespec timeout{ 0, timeout_ns };
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout,
+        nullptr, 0);
+}
+
+size_t SpinLimit(size_t spins) {
+    return std::thread::hardware_concurrency() > 1 ? spins : 0;
+}
+
+void FutexWake(std::atomic<uint32_t>* word) {
+    word->fetch_add(1);
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT32_MAX, nullptr,
+        nullptr, 0);
+}
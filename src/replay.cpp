@@ -0,0 +1,288 @@
+#include "memory_manager/async_io.h"
+#include "memory_manager/replay.h"
+#include "memory_manager/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+std::vector<size_t> DetectHotSizes(const std::vector<MemoryManagerQuery>& queries,
+    size_t max_sizes, double min_share) {
+
+    std::unordered_map<size_t, size_t> size_counts;
+    size_t allocations_count = 0;
+    for (const MemoryManagerQuery& query : queries) {
+        if (auto allocation_query = query.AsAllocationQuery()) {
+            ++size_counts[allocation_query->allocation_size];
+            ++allocations_count;
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> counted_sizes;
+    for (const auto& size_count : size_counts) {
+        counted_sizes.emplace_back(size_count.second, size_count.first);
+    }
+    std::sort(counted_sizes.rbegin(), counted_sizes.rend());
+    std::vector<size_t> hot_sizes;
+    for (const auto& counted_size : counted_sizes) {
+        if (hot_sizes.size() == max_sizes ||
+            counted_size.first < min_share * allocations_count) {
+            break;
+        }
+        hot_sizes.push_back(counted_size.second);
+    }
+    return hot_sizes;
+}
+
+std::vector<MemoryManagerAllocationResponse> RunMemoryManager(
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    const ReplayOptions& options) {
+
+    std::vector<MemoryManagerAllocationResponse> responses;
+    //      kSlab,     
+    //    trace'.
+    const bool detect_hot_sizes =
+        options.engine == MemoryManagerEngine::kSlab && options.hot_sizes.empty();
+    VisitMemoryEngine(memory_size, options,
+        detect_hot_sizes ? DetectHotSizes(queries) : options.hot_sizes,
+        [&](auto& memory) {
+            responses = RunMemoryManager(memory, queries);
+        });
+    return responses;
+}
+
+std::vector<MemoryManagerAllocationResponse> RunArenaMemoryManagers(
+    size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    const ReplayOptions& options) {
+
+    const bool has_arenas = std::any_of(queries.begin(), queries.end(),
+        [](const MemoryManagerQuery& query) {
+            const AllocationQuery* allocation_query = query.AsAllocationQuery();
+            return allocation_query != nullptr && allocation_query->arena != kDefaultArena;
+        });
+    if (!has_arenas) {
+        return RunMemoryManager(memory_size, queries, options);
+    }
+
+    //   -    arena_queries     .
+    std::vector<uint32_t> query_arenas(queries.size());
+    std::vector<uint32_t> local_indices(queries.size());
+    std::unordered_map<ArenaId, uint32_t> arena_indices;
+    std::vector<std::vector<MemoryManagerQuery>> arena_queries;
+    for (size_t current_query = 0; current_query < queries.size(); ++current_query) {
+        const MemoryManagerQuery& query = queries[current_query];
+        if (const AllocationQuery* allocation_query = query.AsAllocationQuery()) {
+            const auto arena_index = arena_indices.emplace(allocation_query->arena,
+                static_cast<uint32_t>(arena_queries.size())).first->second;
+            if (arena_index == arena_queries.size()) {
+                arena_queries.emplace_back();
+            }
+            query_arenas[current_query] = arena_index;
+            local_indices[current_query] = static_cast<uint32_t>(arena_queries[arena_index].size());
+            arena_queries[arena_index].push_back(query);
+            continue;
+        }
+        //         .
+        const size_t freed_query = query.AsFreeQuery()->allocation_query_index - 1;
+        if (freed_query >= current_query || queries[freed_query].AsAllocationQuery() == nullptr) {
+            continue;
+        }
+        arena_queries[query_arenas[freed_query]].emplace_back(
+            FreeQuery{ static_cast<int>(local_indices[freed_query]) + 1 });
+    }
+
+    std::vector<std::vector<MemoryManagerAllocationResponse>> arena_responses(arena_queries.size());
+    std::vector<std::exception_ptr> arena_errors(arena_queries.size());
+    const size_t threads_count = options.threads_count != 0 ?
+        options.threads_count : std::thread::hardware_concurrency();
+    if (threads_count <= 1) {
+        for (size_t arena = 0; arena < arena_queries.size(); ++arena) {
+            arena_responses[arena] = RunMemoryManager(memory_size, arena_queries[arena], options);
+        }
+    } else {
+        WorkStealingThreadPool pool(std::min(threads_count, arena_queries.size()));
+        for (size_t arena = 0; arena < arena_queries.size(); ++arena) {
+            pool.Submit([&, arena] {
+                try {
+                    arena_responses[arena] = RunMemoryManager(memory_size, arena_queries[arena], options);
+                } catch (...) {
+                    arena_errors[arena] = std::current_exception();
+                }
+            });
+        }
+        pool.Wait();
+    }
+    for (const std::exception_ptr& error : arena_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::vector<MemoryManagerAllocationResponse> responses;
+    responses.reserve(queries.size());
+    std::vector<size_t> next_responses(arena_queries.size(), 0);
+    for (size_t current_query = 0; current_query < queries.size(); ++current_query) {
+        if (queries[current_query].AsAllocationQuery() != nullptr) {
+            const uint32_t arena = query_arenas[current_query];
+            responses.push_back(arena_responses[arena][next_responses[arena]++]);
+        }
+    }
+    return responses;
+}
+
+void ReplayTraceStream(FastInputReader& input_reader, std::ostream& ostream,
+    const ReplayOptions& options) {
+    if (input_reader.StartsWith(kBinaryTraceMagic, sizeof(kBinaryTraceMagic))) {
+        BinaryTraceReader trace_reader(input_reader);
+        ReplayTrace(trace_reader, ostream, options);
+    } else {
+        TextTraceReader trace_reader(input_reader);
+        ReplayTrace(trace_reader, ostream, options);
+    }
+}
+
+void ReplayTraceFile(const std::string& path, std::ostream& ostream, const ReplayOptions& options) {
+    if (!std::filesystem::is_regular_file(path)) {
+        //   FIFO (, "<(...)")    :
+        //   ,    .
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        try {
+            FastInputReader input_reader(file);
+            ReplayTraceStream(input_reader, ostream, options);
+        } catch (...) {
+            std::fclose(file);
+            throw;
+        }
+        std::fclose(file);
+        return;
+    }
+    MappedFile trace(path);
+    if (IsBinaryTrace(trace.begin(), trace.end())) {
+        BinaryTraceReader trace_reader(trace.begin(), trace.end());
+        ReplayTrace(trace_reader, ostream, options);
+    } else {
+        FastInputReader input_reader(trace.begin(), trace.end());
+        TextTraceReader trace_reader(input_reader);
+        ReplayTrace(trace_reader, ostream, options);
+    }
+}
+
+bool RunBatchReplay(const ReplayOptions& options) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> trace_paths;
+    if (fs::is_directory(options.batch_path)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(options.batch_path)) {
+            if (entry.is_regular_file()) {
+                trace_paths.push_back(entry.path());
+            }
+        }
+    } else {
+        std::ifstream manifest(options.batch_path);
+        if (!manifest) {
+            throw std::runtime_error("Cannot open " + options.batch_path);
+        }
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                trace_paths.push_back(line);
+            }
+        }
+    }
+    struct BatchTrace {
+        uintmax_t size;
+        fs::path path;
+        std::string output_name;
+    };
+    std::vector<BatchTrace> batch_traces;
+    std::unordered_set<std::string> output_names;
+    for (const fs::path& path : trace_paths) {
+        std::error_code error;
+        const uintmax_t size = fs::file_size(path, error);
+        //         
+        //  .2, .3, ...   ,      .out.
+        std::string output_name = path.filename().string();
+        for (size_t copy = 2; !output_names.insert(output_name).second; ++copy) {
+            output_name = path.filename().string() + "." + std::to_string(copy);
+        }
+        batch_traces.push_back(BatchTrace{ error ? 0 : size, path, output_name + ".out" });
+    }
+    std::sort(batch_traces.begin(), batch_traces.end(),
+        [](const BatchTrace& first, const BatchTrace& second) {
+            return first.size > second.size;
+        });
+
+    const fs::path output_dir = options.output_dir.empty() ? fs::path(".") : fs::path(options.output_dir);
+    fs::create_directories(output_dir);
+    ReplayOptions trace_options = options;
+    trace_options.batch_path.clear();
+    //    trace':   trace'  
+    //   ,        trace.
+    trace_options.threads_count = 1;
+    std::vector<double> seconds(batch_traces.size(), 0);
+    std::vector<std::string> errors(batch_traces.size());
+    {
+        WorkStealingThreadPool pool(options.threads_count != 0 ?
+            options.threads_count : std::thread::hardware_concurrency());
+        for (size_t trace = 0; trace < batch_traces.size(); ++trace) {
+            pool.Submit([&, trace] {
+                const fs::path& path = batch_traces[trace].path;
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    std::ofstream output(output_dir / batch_traces[trace].output_name,
+                        std::ios::binary);
+                    if (!output) {
+                        throw std::runtime_error("Cannot create output for " + path.string());
+                    }
+                    ReplayTraceFile(path.string(), output, trace_options);
+                } catch (const std::exception& error) {
+                    errors[trace] = error.what();
+                }
+                seconds[trace] = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+            });
+        }
+        pool.Wait();
+    }
+
+    std::ofstream timings(output_dir / "timings.tsv");
+    timings << "trace\tbytes\tseconds\tstatus\n";
+    bool success = true;
+    for (size_t trace = 0; trace < batch_traces.size(); ++trace) {
+        timings << batch_traces[trace].path.string() << "\t" << batch_traces[trace].size
+            << "\t" << seconds[trace] << "\t"
+            << (errors[trace].empty() ? "ok" : errors[trace]) << "\n";
+        success = success && errors[trace].empty();
+    }
+    return success;
+}
+
+void ReplayWithAsyncIo(const ReplayOptions& options) {
+    AsyncFileWriter output_buffer(STDOUT_FILENO);
+    std::ostream output(&output_buffer);
+    if (options.trace_path.empty()) {
+        AsyncFileReader input(STDIN_FILENO);
+        FastInputReader input_reader(&input);
+        ReplayTraceStream(input_reader, output, options);
+    } else {
+        ReplayTraceFile(options.trace_path, output, options);
+    }
+    output_buffer.Finish();
+}
@@ -0,0 +1,143 @@
+#include "memory_manager/trace_io.h"
+
+size_t ReadMemorySize(std::istream& stream) {
+    size_t memory_size;
+    if (!(stream >> memory_size)) {
+        throw std::runtime_error("Missing memory size in trace");
+    }
+    return memory_size;
+}
+
+size_t ReadMemorySize(FastInputReader& reader) {
+    size_t memory_size = 0;
+    if (!reader.ReadInteger(&memory_size)) {
+        throw std::runtime_error("Missing memory size in trace");
+    }
+    return memory_size;
+}
+
+std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(std::istream& stream) {
+    size_t queries_size;
+    if (!(stream >> queries_size)) {
+        throw std::runtime_error("Missing queries count in trace");
+    }
+    std::vector<MemoryManagerQuery> queries;
+    for (size_t current_query = 0; current_query < queries_size; ++current_query) {
+        int abstract_query;
+        stream >> abstract_query;
+        if (abstract_query > 0) {
+            AllocationQuery allocation_query{ static_cast<size_t>(abstract_query) };
+            if (stream.peek() == ':') {
+                stream.get();
+                stream >> allocation_query.tenant;
+            }
+            if (stream.peek() == '@') {
+                stream.get();
+                stream >> allocation_query.arena;
+            }
+            queries.emplace_back(allocation_query);
+        }
+        if (abstract_query < 0) {
+            queries.emplace_back(FreeQuery{ -abstract_query });
+        }
+    }
+    return queries;
+}
+
+std::vector<MemoryManagerQuery> ReadMemoryManagerQueries(FastInputReader& reader) {
+    size_t queries_size = 0;
+    if (!reader.ReadInteger(&queries_size)) {
+        throw std::runtime_error("Missing queries count in trace");
+    }
+    std::vector<MemoryManagerQuery> queries;
+    queries.reserve(queries_size);
+    std::optional<MemoryManagerQuery> query;
+    for (size_t current_query = 0; current_query < queries_size; ++current_query) {
+        if (!ReadMemoryManagerQuery(reader, &query)) {
+            break;
+        }
+        if (query) {
+            queries.push_back(*query);
+        }
+    }
+    return queries;
+}
+
+bool IsBinaryTrace(const char* begin, const char* end) {
+    return end - begin >= static_cast<ptrdiff_t>(sizeof(kBinaryTraceMagic)) &&
+        std::memcmp(begin, kBinaryTraceMagic, sizeof(kBinaryTraceMagic)) == 0;
+}
+
+void WriteVarint(uint64_t value, std::string* output) {
+    while (value >= 0x80) {
+        output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    output->push_back(static_cast<char>(value));
+}
+
+void WriteBinaryTrace(size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    std::ostream& ostream) {
+    uint8_t flags = 0;
+    for (const MemoryManagerQuery& query : queries) {
+        const AllocationQuery* allocation_query = query.AsAllocationQuery();
+        if (allocation_query != nullptr && allocation_query->tenant != kDefaultTenant) {
+            flags |= kBinaryTraceHasTenants;
+        }
+        if (allocation_query != nullptr && allocation_query->arena != kDefaultArena) {
+            flags |= kBinaryTraceHasArenas;
+        }
+    }
+    std::string output(kBinaryTraceMagic, sizeof(kBinaryTraceMagic));
+    output.push_back(static_cast<char>(kBinaryTraceVersion));
+    output.push_back(static_cast<char>(flags));
+    WriteVarint(memory_size, &output);
+    WriteVarint(queries.size(), &output);
+    for (size_t current_query = 0; current_query < queries.size(); ++current_query) {
+        int64_t value;
+        const AllocationQuery* allocation_query = queries[current_query].AsAllocationQuery();
+        if (allocation_query != nullptr) {
+            value = allocation_query->allocation_size;
+        } else {
+            value = queries[current_query].AsFreeQuery()->allocation_query_index -
+                static_cast<int64_t>(current_query + 1);
+        }
+        WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63),
+            &output);
+        if (allocation_query != nullptr && (flags & kBinaryTraceHasTenants)) {
+            WriteVarint(allocation_query->tenant, &output);
+        }
+        if (allocation_query != nullptr && (flags & kBinaryTraceHasArenas)) {
+            WriteVarint(allocation_query->arena, &output);
+        }
+    }
+    ostream.write(output.data(), output.size());
+}
+
+void WriteTextTrace(size_t memory_size, const std::vector<MemoryManagerQuery>& queries,
+    std::ostream& ostream) {
+    ostream << memory_size << " " << queries.size() << "\n";
+    for (const MemoryManagerQuery& query : queries) {
+        if (const AllocationQuery* allocation_query = query.AsAllocationQuery()) {
+            ostream << allocation_query->allocation_size;
+            if (allocation_query->tenant != kDefaultTenant) {
+                ostream << ":" << allocation_query->tenant;
+            }
+            if (allocation_query->arena != kDefaultArena) {
+                ostream << "@" << allocation_query->arena;
+            }
+        } else {
+            ostream << -query.AsFreeQuery()->allocation_query_index;
+        }
+        ostream << "\n";
+    }
+}
+
+void OutputMemoryManagerResponses(const std::vector<MemoryManagerAllocationResponse>& responses,
+    std::ostream& ostream) {
+    FastOutputWriter writer(ostream);
+    for (size_t current_response = 0; current_response < responses.size(); ++current_response) {
+        OutputMemoryManagerResponse(responses[current_response], writer);
+    }
+    writer.WriteChar('\n');
+}
@@ -0,0 +1,907 @@
+#include "memory_manager/bitmap_memory_manager.h"
+#include "memory_manager/heap.h"
+#include "memory_manager/memory_manager.h"
+#include "memory_manager/query.h"
+#include "memory_manager/radix_tree.h"
+#include "memory_manager/replay.h"
+#include "memory_manager/slab_memory_manager.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <random>
+#include <utility>
+#include <vector>
+
+/*
+*   :     std::map, 
+*         (
+*  -  ),     .
+*/
+
+class ReferenceMemoryManager {
+public:
+    explicit ReferenceMemoryManager(size_t memory_size) {
+        free_segments_[1] = memory_size;
+    }
+
+    size_t Allocate(size_t size) {
+        auto best = free_segments_.end();
+        for (auto segment = free_segments_.begin(); segment != free_segments_.end(); ++segment) {
+            if (best == free_segments_.end() ||
+                segment->second - segment->first > best->second - best->first) {
+                best = segment;
+            }
+        }
+        if (best == free_segments_.end() || best->second - best->first + 1 < size) {
+            return 0;
+        }
+        return Take(best->first, size);
+    }
+
+    //  [position, position + size),    .
+    size_t Take(size_t position, size_t size) {
+        auto segment = std::prev(free_segments_.upper_bound(position));
+        const size_t left = segment->first;
+        const size_t right = segment->second;
+        free_segments_.erase(segment);
+        if (left < position) {
+            free_segments_[left] = position - 1;
+        }
+        if (position + size <= right) {
+            free_segments_[position + size] = right;
+        }
+        allocated_segments_[position] = position + size - 1;
+        return position;
+    }
+
+    void Free(size_t position) {
+        size_t left = position;
+        size_t right = allocated_segments_.at(position);
+        allocated_segments_.erase(position);
+        auto next = free_segments_.find(right + 1);
+        if (next != free_segments_.end()) {
+            right = next->second;
+            free_segments_.erase(next);
+        }
+        auto previous = free_segments_.lower_bound(left);
+        if (previous != free_segments_.begin() && std::prev(previous)->second + 1 == left) {
+            --previous;
+            left = previous->first;
+            free_segments_.erase(previous);
+        }
+        free_segments_[left] = right;
+    }
+
+    //     [position, position + size).
+    bool IsFree(size_t position, size_t size) const {
+        auto segment = free_segments_.upper_bound(position);
+        if (segment == free_segments_.begin()) {
+            return false;
+        }
+        --segment;
+        return segment->second >= position + size - 1;
+    }
+
+    const std::map<size_t, size_t>& FreeSegments() const {
+        return free_segments_;
+    }
+
+private:
+    std::map<size_t, size_t> free_segments_;
+    std::map<size_t, size_t> allocated_segments_;
+};
+
+/*
+*     : 
+*   ,    .
+*/
+std::vector<MemoryManagerQuery> MakeRandomQueries(size_t count, size_t max_size,
+    std::mt19937* random) {
+    std::vector<MemoryManagerQuery> queries;
+    std::vector<int> allocations;
+    for (size_t current_query = 0; current_query < count; ++current_query) {
+        if (!allocations.empty() && (*random)() % 3 == 0) {
+            const size_t freed = (*random)() % allocations.size();
+            queries.emplace_back(FreeQuery{ allocations[freed] });
+            allocations.erase(allocations.begin() + freed);
+        } else {
+            queries.emplace_back(AllocationQuery{ 1 + (*random)() % max_size });
+            allocations.push_back(static_cast<int>(current_query + 1));
+        }
+    }
+    return queries;
+}
+
+// ,      queries (0 - ).
+std::vector<size_t> ReferencePositions(size_t memory_size,
+    const std::vector<MemoryManagerQuery>& queries) {
+    ReferenceMemoryManager reference(memory_size);
+    std::vector<size_t> positions;
+    std::vector<size_t> allocated(queries.size(), 0);
+    for (size_t current_query = 0; current_query < queries.size(); ++current_query) {
+        if (const AllocationQuery* allocation_query = queries[current_query].AsAllocationQuery()) {
+            allocated[current_query] = reference.Allocate(allocation_query->allocation_size);
+            positions.push_back(allocated[current_query]);
+        } else {
+            size_t& position = allocated[queries[current_query].AsFreeQuery()->allocation_query_index - 1];
+            if (position != 0) {
+                reference.Free(position);
+                position = 0;
+            }
+        }
+    }
+    return positions;
+}
+
+TEST(AllocateFreeMatchesOriginalAlgorithm) {
+    std::mt19937 random(1);
+    for (size_t memory_size : { 1, 10, 100, 1000, 100000 }) {
+        const std::vector<MemoryManagerQuery> queries =
+            MakeRandomQueries(3000, memory_size / 4 + 1, &random);
+        const std::vector<size_t> expected = ReferencePositions(memory_size, queries);
+        const std::vector<MemoryManagerAllocationResponse> responses =
+            RunMemoryManager(memory_size, queries);
+        CHECK(responses.size() == expected.size());
+        for (size_t response = 0; response < responses.size(); ++response) {
+            CHECK(responses[response].success == (expected[response] != 0));
+            CHECK(!responses[response].success || responses[response].position == expected[response]);
+        }
+    }
+}
+
+TEST(RadixTreeMatchesMap) {
+    std::mt19937_64 random(11);
+    RadixTree<size_t> tree;
+    std::map<size_t, size_t> expected;
+    for (size_t step = 0; step < 200000; ++step) {
+        //   ,     32- .
+        const size_t key = step % 2 == 0 ? random() % 4096 : random() % (size_t(1) << 32);
+        if (random() % 3 == 0) {
+            tree.Erase(key);
+            expected.erase(key);
+        } else {
+            tree.Insert(key, step);
+            expected[key] = step;
+        }
+        const size_t* value = tree.Find(key);
+        const auto found = expected.find(key);
+        CHECK((value == nullptr) == (found == expected.end()));
+        CHECK(value == nullptr || *value == found->second);
+    }
+    CHECK(tree.size() == expected.size());
+    for (const auto& entry : expected) {
+        CHECK(tree.Find(entry.first) != nullptr && *tree.Find(entry.first) == entry.second);
+    }
+    CHECK_THROWS(tree.Insert(size_t(1) << 32, 0));
+}
+
+/*
+*         ,
+*     ,   ,   .
+*/
+void Fragment(MemoryManager* memory, ReferenceMemoryManager* reference, size_t memory_size,
+    std::mt19937* random) {
+    std::vector<size_t> positions;
+    for (size_t step = 0; step < memory_size / 4; ++step) {
+        MemoryManager::Iterator segment = memory->Allocate(1 + (*random)() % 8);
+        if (segment != memory->end()) {
+            CHECK(reference->Allocate(segment->Size()) == static_cast<size_t>(segment->left));
+            positions.push_back(segment->left);
+        }
+    }
+    std::shuffle(positions.begin(), positions.end(), *random);
+    positions.resize(positions.size() / 2);
+    for (size_t position : positions) {
+        memory->Free(position);
+        reference->Free(position);
+    }
+}
+
+TEST(FindAndFreeByPosition) {
+    std::mt19937 random(12);
+    MemoryManager memory(1000);
+    ReferenceMemoryManager reference(1000);
+    Fragment(&memory, &reference, 1000, &random);
+    for (size_t position = 1; position <= 1000; ++position) {
+        MemoryManager::Iterator segment = memory.Find(position);
+        if (segment != memory.end()) {
+            CHECK(static_cast<size_t>(segment->left) == position);
+            CHECK(!reference.IsFree(position, 1));
+        }
+    }
+    //       -   .
+    for (const auto& free_segment : reference.FreeSegments()) {
+        CHECK(memory.Find(free_segment.first) == memory.end());
+        memory.Free(free_segment.first);
+    }
+    MemoryManager::Iterator segment = memory.Allocate(5);
+    CHECK(segment != memory.end() && static_cast<size_t>(segment->left) == reference.Allocate(5));
+    CHECK(memory.Find(segment->left + 1) == memory.end());
+    const size_t position = segment->left;
+    memory.Free(position);
+    reference.Free(position);
+    CHECK(memory.Find(position) == memory.end());
+}
+
+TEST(PositionIndexIsBuiltOnFirstFind) {
+    std::mt19937 random(13);
+    MemoryManager memory(1000);
+    std::vector<MemoryManager::Iterator> segments;
+    for (size_t step = 0; step < 2000; ++step) {
+        if (!segments.empty() && random() % 2 == 0) {
+            const size_t freed = random() % segments.size();
+            memory.Free(segments[freed]);
+            segments[freed] = segments.back();
+            segments.pop_back();
+        } else {
+            MemoryManager::Iterator segment = memory.Allocate(1 + random() % 8);
+            if (segment != memory.end()) {
+                segments.push_back(segment);
+            }
+        }
+    }
+    //      ;  Find  .
+    std::vector<size_t> allocated;
+    for (MemoryManager::Iterator segment : segments) {
+        allocated.push_back(segment->left);
+    }
+    std::sort(allocated.begin(), allocated.end());
+    std::vector<size_t> found;
+    for (size_t position = 1; position <= 1000; ++position) {
+        if (memory.Find(position) != memory.end()) {
+            found.push_back(position);
+        }
+    }
+    CHECK(found == allocated);
+    for (size_t position : allocated) {
+        memory.Free(position);
+        CHECK(memory.Find(position) == memory.end());
+    }
+    CHECK(memory.Allocate(1000) != memory.end());
+}
+
+/*
+*        :  
+*   64- ,      .
+*/
+TEST(BitmapEngineMatchesReference) {
+    std::mt19937 random(21);
+    for (size_t memory_size : { 1, 63, 64, 65, 1000, 4099 }) {
+        BitmapMemoryManager memory(memory_size);
+        ReferenceMemoryManager reference(memory_size);
+        std::vector<size_t> positions;
+        for (size_t step = 0; step < 5000; ++step) {
+            if (!positions.empty() && random() % 3 == 0) {
+                const size_t freed = random() % positions.size();
+                memory.Free(positions[freed]);
+                reference.Free(positions[freed]);
+                positions.erase(positions.begin() + freed);
+            } else {
+                const size_t size = 1 + random() % (random() % 4 == 0 ? 200 : 8);
+                const size_t position = memory.Allocate(size);
+                CHECK(position == reference.Allocate(size));
+                if (position != BitmapMemoryManager::kNullPosition) {
+                    positions.push_back(position);
+                }
+            }
+            size_t max_free_size = 0;
+            for (const auto& free_segment : reference.FreeSegments()) {
+                max_free_size = std::max(max_free_size, free_segment.second - free_segment.first + 1);
+            }
+            CHECK(memory.MaxFreeSize() == max_free_size);
+        }
+    }
+}
+
+TEST(BitmapEngineReplayMatchesSegmentList) {
+    std::mt19937 random(22);
+    const std::vector<MemoryManagerQuery> queries = MakeRandomQueries(20000, 300, &random);
+    ReplayOptions options;
+    const std::vector<MemoryManagerAllocationResponse> list =
+        RunMemoryManager(10000, queries, options);
+    options.engine = MemoryManagerEngine::kBitmap;
+    const std::vector<MemoryManagerAllocationResponse> bitmap =
+        RunMemoryManager(10000, queries, options);
+    CHECK(list.size() == bitmap.size());
+    for (size_t response = 0; response < list.size(); ++response) {
+        CHECK(list[response].success == bitmap[response].success);
+        CHECK(list[response].position == bitmap[response].position);
+    }
+}
+
+TEST(SlabObjectsDoNotOverlap) {
+    std::mt19937 random(31);
+    const size_t memory_size = 20000;
+    SlabMemoryManager memory(memory_size, { 3, 8, 16 });
+    std::map<size_t, size_t> live;
+    std::vector<size_t> positions;
+    for (size_t step = 0; step < 20000; ++step) {
+        if (!positions.empty() && random() % 3 == 0) {
+            const size_t freed = random() % positions.size();
+            memory.Free(positions[freed]);
+            live.erase(positions[freed]);
+            positions.erase(positions.begin() + freed);
+            continue;
+        }
+        static const size_t kSizes[] = { 3, 8, 16, 5, 40 };
+        const size_t size = kSizes[random() % 5];
+        const size_t position = memory.Allocate(size);
+        if (position == SlabMemoryManager::kNullPosition) {
+            continue;
+        }
+        CHECK(position >= 1 && position + size - 1 <= memory_size);
+        //         .
+        auto next = live.lower_bound(position);
+        CHECK(next == live.end() || next->first >= position + size);
+        CHECK(next == live.begin() || std::prev(next)->second < position);
+        live[position] = position + size - 1;
+        positions.push_back(position);
+    }
+}
+
+TEST(SlabReleasesEmptySlab) {
+    const size_t object_size = 4;
+    const size_t memory_size = object_size * SlabMemoryManager::kObjectsPerSlab;
+    SlabMemoryManager memory(memory_size, { object_size });
+    std::vector<size_t> positions;
+    for (size_t object = 0; object < SlabMemoryManager::kObjectsPerSlab; ++object) {
+        positions.push_back(memory.Allocate(object_size));
+        CHECK(positions.back() != SlabMemoryManager::kNullPosition);
+    }
+    //  slab   .
+    CHECK(memory.Allocate(1) == SlabMemoryManager::kNullPosition);
+    for (size_t position : positions) {
+        memory.Free(position);
+    }
+    //  slab  ,    .
+    CHECK(memory.Allocate(memory_size) == 1);
+}
+
+/*
+*  next-fit:     , 
+*   rover,     -      .
+*/
+size_t NextFitAllocate(ReferenceMemoryManager* reference, size_t size, size_t* rover) {
+    const std::map<size_t, size_t>& free_segments = reference->FreeSegments();
+    for (size_t from : { *rover, size_t(0) }) {
+        for (auto segment = free_segments.lower_bound(from); segment != free_segments.end(); ++segment) {
+            if (segment->second - segment->first + 1 >= size) {
+                const size_t position = reference->Take(segment->first, size);
+                *rover = position + size;
+                return position;
+            }
+        }
+    }
+    return 0;
+}
+
+TEST(NextFitMatchesReference) {
+    std::mt19937 random(41);
+    for (size_t memory_size : { 1, 17, 1000, 30000 }) {
+        MemoryManager memory(memory_size, AllocationPolicy::kNextFit);
+        ReferenceMemoryManager reference(memory_size);
+        size_t rover = 1;
+        std::vector<size_t> positions;
+        for (size_t step = 0; step < 10000; ++step) {
+            if (!positions.empty() && random() % 3 == 0) {
+                const size_t freed = random() % positions.size();
+                memory.Free(positions[freed]);
+                reference.Free(positions[freed]);
+                positions.erase(positions.begin() + freed);
+            } else {
+                const size_t size = 1 + random() % (memory_size / 16 + 1);
+                MemoryManager::Iterator segment = memory.Allocate(size);
+                const size_t expected = NextFitAllocate(&reference, size, &rover);
+                CHECK((segment == memory.end()) == (expected == 0));
+                if (segment != memory.end()) {
+                    CHECK(static_cast<size_t>(segment->left) == expected);
+                    positions.push_back(expected);
+                }
+            }
+        }
+    }
+}
+
+TEST(NextFitRoverAdvancesAndWrapsAround) {
+    MemoryManager memory(30, AllocationPolicy::kNextFit);
+    const size_t first = memory.Allocate(10)->left;
+    const size_t second = memory.Allocate(10)->left;
+    CHECK(first == 1 && second == 11);
+    memory.Free(first);
+    // Rover   21:    .
+    CHECK(memory.Allocate(5)->left == 21);
+    //   rover  5 ,     .
+    CHECK(memory.Allocate(6)->left == 1);
+    CHECK(memory.Allocate(4)->left == 7);
+    CHECK(memory.Allocate(5)->left == 26);
+    CHECK(memory.Allocate(1) == memory.end());
+}
+
+TEST(NextFitRoverInsideCoalescedSegment) {
+    MemoryManager memory(40, AllocationPolicy::kNextFit);
+    memory.Allocate(10);
+    const size_t second = memory.Allocate(10)->left;
+    const size_t third = memory.Allocate(10)->left;
+    memory.Free(third);
+    // Rover (31)     [21, 40].
+    memory.Free(second);
+    //     [11, 40]   rover 
+    //       .
+    CHECK(memory.Allocate(25)->left == 11);
+    CHECK(memory.Allocate(5)->left == 36);
+    CHECK(memory.Allocate(1) == memory.end());
+}
+
+TEST(AllocateInRangeMatchesBruteForce) {
+    constexpr size_t kMemorySize = 400;
+    std::mt19937 random(2);
+    for (size_t round = 0; round < 20; ++round) {
+        MemoryManager memory(kMemorySize);
+        ReferenceMemoryManager reference(kMemorySize);
+        Fragment(&memory, &reference, kMemorySize, &random);
+        for (size_t query = 0; query < 200; ++query) {
+            const size_t size = 1 + random() % 6;
+            size_t lo = 1 + random() % kMemorySize;
+            size_t hi = 1 + random() % kMemorySize;
+            if (lo > hi) {
+                std::swap(lo, hi);
+            }
+            size_t expected = 0;
+            for (size_t position = lo; position + size - 1 <= hi; ++position) {
+                if (reference.IsFree(position, size)) {
+                    expected = position;
+                    break;
+                }
+            }
+            MemoryManager::Iterator segment = memory.AllocateInRange(size, lo, hi);
+            CHECK((segment == memory.end()) == (expected == 0));
+            if (segment != memory.end()) {
+                CHECK(static_cast<size_t>(segment->left) == expected);
+                CHECK(segment->Size() == size);
+                memory.Free(segment);
+            }
+        }
+    }
+}
+
+TEST(AllocateNearMatchesBruteForce) {
+    constexpr size_t kMemorySize = 400;
+    std::mt19937 random(3);
+    for (size_t round = 0; round < 20; ++round) {
+        MemoryManager memory(kMemorySize);
+        ReferenceMemoryManager reference(kMemorySize);
+        Fragment(&memory, &reference, kMemorySize, &random);
+        for (size_t query = 0; query < 200; ++query) {
+            const size_t size = 1 + random() % 6;
+            const size_t hint = 1 + random() % kMemorySize;
+            size_t expected = 0;
+            for (size_t position = 1; position + size - 1 <= kMemorySize; ++position) {
+                const size_t distance = position > hint ? position - hint : hint - position;
+                const size_t best_distance = expected > hint ? expected - hint : hint - expected;
+                if (reference.IsFree(position, size) &&
+                    (expected == 0 || distance < best_distance)) {
+                    expected = position;
+                }
+            }
+            MemoryManager::Iterator segment = memory.AllocateNear(size, hint);
+            CHECK((segment == memory.end()) == (expected == 0));
+            if (segment != memory.end()) {
+                CHECK(static_cast<size_t>(segment->left) == expected);
+                memory.Free(segment);
+            }
+        }
+    }
+}
+
+
+
+TEST(TenantHardAndSoftQuotas) {
+    MemoryManager memory(100);
+    TenantLimits limits;
+    limits.soft_quota = 5;
+    limits.hard_quota = 8;
+    memory.SetTenantLimits(1, limits);
+    CHECK(memory.Allocate(6, 1) != memory.end());
+    CHECK(memory.Allocate(3, 1) == memory.end());
+    CHECK(memory.Allocate(2, 1) != memory.end());
+    const TenantUsage usage = memory.GetTenantUsage(1);
+    CHECK(usage.used == 8);
+    CHECK(usage.soft_quota_violations == 2);
+    CHECK(usage.rejected_allocations == 1);
+    CHECK(memory.Allocate(50, 2) != memory.end());
+}
+
+TEST(TenantReservationIsKeptFree) {
+    MemoryManager memory(20);
+    TenantLimits limits;
+    limits.reservation = 10;
+    memory.SetTenantLimits(2, limits);
+    CHECK(memory.Allocate(15, 3) == memory.end());
+    MemoryManager::Iterator other = memory.Allocate(10, 3);
+    CHECK(other != memory.end());
+    CHECK(memory.Allocate(1, 3) == memory.end());
+    CHECK(memory.Allocate(10, 2) != memory.end());
+    memory.Free(other);
+    CHECK(memory.GetTenantUsage(3).used == 0);
+    CHECK(memory.GetTenantUsage(3).rejected_allocations == 2);
+}
+
+TEST(FailedAllocateBatchRestoresState) {
+    std::mt19937 random(4);
+    for (size_t round = 0; round < 50; ++round) {
+        MemoryManager memory(200);
+        MemoryManager untouched(200);
+        ReferenceMemoryManager reference(200);
+        ReferenceMemoryManager untouched_reference(200);
+        std::mt19937 fragment_random(round);
+        Fragment(&memory, &reference, 200, &fragment_random);
+        fragment_random.seed(round);
+        Fragment(&untouched, &untouched_reference, 200, &fragment_random);
+
+        std::vector<size_t> sizes(1 + random() % 5);
+        for (size_t& size : sizes) {
+            size = 1 + random() % 10;
+        }
+        sizes.push_back(1000);
+        std::vector<MemoryManager::Iterator> segments;
+        CHECK(!memory.AllocateBatch(sizes, &segments));
+        CHECK(segments.empty());
+        CHECK(memory.GetTenantUsage(kDefaultTenant).used ==
+            untouched.GetTenantUsage(kDefaultTenant).used);
+        for (size_t step = 0; step < 100; ++step) {
+            const size_t size = 1 + random() % 10;
+            MemoryManager::Iterator segment = memory.Allocate(size);
+            MemoryManager::Iterator expected = untouched.Allocate(size);
+            CHECK((segment == memory.end()) == (expected == untouched.end()));
+            CHECK(segment == memory.end() || segment->left == expected->left);
+        }
+    }
+}
+
+TEST(SuccessfulAllocateBatchMatchesSequentialAllocations) {
+    MemoryManager memory(100);
+    MemoryManager sequential(100);
+    const std::vector<size_t> sizes = { 10, 20, 30 };
+    std::vector<MemoryManager::Iterator> segments;
+    CHECK(memory.AllocateBatch(sizes, &segments));
+    CHECK(segments.size() == sizes.size());
+    for (size_t index = 0; index < sizes.size(); ++index) {
+        CHECK(segments[index]->left == sequential.Allocate(sizes[index])->left);
+    }
+}
+
+TEST(ThrowingAllocateBatchLeavesManagerUsable) {
+    MemoryManager memory(100);
+    MemoryManager untouched(100);
+    const std::vector<size_t> sizes = { 10, 20 };
+    std::vector<MemoryManager::Iterator> segments;
+    CHECK_THROWS(memory.AllocateBatch(sizes, &segments, TenantQuotas::kMaxTenants));
+    CHECK(segments.empty());
+    //         .
+    for (size_t size : { 5, 15, 25 }) {
+        CHECK(memory.Allocate(size)->left == untouched.Allocate(size)->left);
+    }
+    const std::vector<size_t> too_large = { 10, 100 };
+    CHECK(!memory.AllocateBatch(too_large, &segments));
+    CHECK(memory.AllocateBatch(sizes, &segments));
+    CHECK(segments.size() == 2 && segments[0]->left == untouched.Allocate(10)->left);
+}
+
+TEST(RejectedAllocateBatchIsCountedOnce) {
+    MemoryManager memory(100);
+    TenantLimits limits;
+    limits.hard_quota = 30;
+    memory.SetTenantLimits(1, limits);
+    std::vector<MemoryManager::Iterator> segments;
+    const std::vector<size_t> over_quota = { 10, 10, 10, 10 };
+    CHECK(!memory.AllocateBatch(over_quota, &segments, 1));
+    CHECK(memory.GetTenantUsage(1).rejected_allocations == 1);
+    CHECK(memory.GetTenantUsage(1).used == 0);
+    const std::vector<size_t> within_quota = { 10, 10, 10 };
+    CHECK(memory.AllocateBatch(within_quota, &segments, 1));
+    CHECK(memory.GetTenantUsage(1).rejected_allocations == 1);
+    CHECK(memory.GetTenantUsage(1).used == 30);
+}
+
+/*
+*   10 :  [1, 6]  [7, 10],   8, 3  2.
+*   [7, 10]  4 ,    
+*    .
+*/
+std::vector<size_t> ServeAfterFree(WaitingQueuePolicy policy) {
+    MemoryManager memory(10);
+    memory.SetWaitingQueuePolicy(policy);
+    memory.Allocate(6);
+    MemoryManager::Iterator freed = memory.Allocate(4);
+    std::vector<size_t> served;
+    for (size_t size : { 8, 3, 2 }) {
+        const MemoryManager::WaitTicket ticket = memory.AllocateOrWait(size,
+            [&served, size](MemoryManager::Iterator) {
+                served.push_back(size);
+            });
+        CHECK(ticket != MemoryManager::kCompletedTicket);
+    }
+    memory.Free(freed);
+    return served;
+}
+
+TEST(WaitingQueuePolicies) {
+    CHECK(ServeAfterFree(WaitingQueuePolicy::kFifo).empty());
+    CHECK(ServeAfterFree(WaitingQueuePolicy::kSmallestFirst) == std::vector<size_t>({ 2 }));
+    CHECK(ServeAfterFree(WaitingQueuePolicy::kFirstFit) == std::vector<size_t>({ 3 }));
+}
+
+TEST(FifoQueueServesInArrivalOrder) {
+    MemoryManager memory(10);
+    MemoryManager::Iterator segment = memory.Allocate(10);
+    std::vector<int> served;
+    memory.AllocateOrWait(5, [&](MemoryManager::Iterator allocated) {
+        served.push_back(allocated->left);
+    });
+    memory.AllocateOrWait(2, [&](MemoryManager::Iterator allocated) {
+        served.push_back(allocated->left);
+    });
+    CHECK(memory.WaitingCount() == 2);
+    memory.Free(segment);
+    CHECK(served == std::vector<int>({ 1, 6 }));
+    CHECK(memory.WaitingCount() == 0);
+}
+
+AsyncTask AllocateInCoroutine(MemoryManager& memory, CoroutineExecutor* executor, int* position) {
+    MemoryManager::Iterator segment = co_await memory.AllocateAsync(4, executor);
+    *position = segment->left;
+}
+
+TEST(AllocateAsyncResumesThroughExecutor) {
+    MemoryManager memory(10);
+    CoroutineExecutor executor;
+    MemoryManager::Iterator segment = memory.Allocate(8);
+    int position = 0;
+    executor.Spawn(AllocateInCoroutine(memory, &executor, &position));
+    executor.Run();
+    CHECK(position == 0);
+    CHECK(memory.WaitingCount() == 1);
+    memory.Free(segment);
+    CHECK(position == 0);
+    executor.Run();
+    CHECK(position == 1);
+}
+
+TEST(LeaseExpiresAfterTtl) {
+    MemoryManager memory(10);
+    MemoryManager::Iterator segment = memory.AllocateWithTtl(10, 5);
+    CHECK(segment != memory.end());
+    size_t served = 0;
+    memory.AllocateOrWait(3, [&](MemoryManager::Iterator) {
+        ++served;
+    });
+    memory.AdvanceTime(4);
+    CHECK(memory.Find(1) != memory.end());
+    CHECK(served == 0);
+    memory.AdvanceTime(5);
+    CHECK(served == 1);
+    CHECK(memory.Allocate(7) != memory.end());
+}
+
+TEST(StaleLeaseDoesNotFreeReusedPosition) {
+    MemoryManager memory(10);
+    memory.Free(memory.AllocateWithTtl(5, 3));
+    MemoryManager::Iterator segment = memory.Allocate(5);
+    CHECK(segment->left == 1);
+    memory.AdvanceTime(100);
+    CHECK(memory.Find(1) != memory.end());
+    CHECK(memory.Allocate(10) == memory.end());
+}
+
+TEST(LeasesAcrossTimerWheelLevels) {
+    MemoryManager memory(1000);
+    std::mt19937 random(5);
+    std::map<int, MemoryManager::Tick> deadlines;
+    for (size_t lease = 0; lease < 200; ++lease) {
+        const MemoryManager::Tick ttl = 1 + random() % 100000;
+        MemoryManager::Iterator segment = memory.AllocateWithTtl(1, ttl);
+        deadlines[segment->left] = ttl;
+    }
+    for (MemoryManager::Tick now = 0; now <= 100000; now += 1 + random() % 5000) {
+        memory.AdvanceTime(now);
+        for (const auto& deadline : deadlines) {
+            CHECK((memory.Find(deadline.first) != memory.end()) == (deadline.second > now));
+        }
+    }
+}
+
+TEST(AllocationHandleTableKeepsSegmentIterators) {
+    MemoryManager memory(100);
+    AllocationHandleTable<MemoryManager::Iterator> handles;
+    const AllocationHandle first = handles.Insert(memory.Allocate(10));
+    const AllocationHandle second = handles.Insert(memory.Allocate(20));
+    memory.Free(handles.Release(first));
+    //   ,   .
+    const AllocationHandle third = handles.Insert(memory.Allocate(5));
+    CHECK(third == first);
+    MemoryManager::Iterator segment = handles.Release(second);
+    CHECK(segment->left == 11 && segment->Size() == 20);
+    memory.Free(segment);
+    memory.Free(handles.Release(third));
+    CHECK(memory.Allocate(100) != memory.end());
+}
+
+TEST(QueryHandleMapKeepsLiveEntries) {
+    std::mt19937 random(6);
+    QueryHandleMap handles;
+    std::map<size_t, QueryHandleMap::Handle> expected;
+    for (size_t query_index = 0; query_index < 100000; ++query_index) {
+        if (random() % 2 == 0) {
+            handles.Insert(query_index, static_cast<QueryHandleMap::Handle>(query_index * 7));
+            expected[query_index] = static_cast<QueryHandleMap::Handle>(query_index * 7);
+        }
+        if (!expected.empty() && random() % 3 == 0) {
+            auto extracted = expected.lower_bound(random() % (query_index + 1));
+            if (extracted == expected.end()) {
+                extracted = expected.begin();
+            }
+            QueryHandleMap::Handle handle = 0;
+            CHECK(handles.Extract(extracted->first, &handle));
+            CHECK(handle == extracted->second);
+            CHECK(!handles.Extract(extracted->first, &handle));
+            expected.erase(extracted);
+        }
+    }
+    for (const auto& entry : expected) {
+        QueryHandleMap::Handle handle = 0;
+        CHECK(handles.Extract(entry.first, &handle));
+        CHECK(handle == entry.second);
+    }
+}
+
+TEST(HeapMatchesMultisetWithIndexObserver) {
+    std::mt19937 random(51);
+    std::vector<size_t> indices;
+    //  -  ,      observer.
+    std::vector<int> keys;
+    auto compare = [&keys](size_t first, size_t second) {
+        return keys[first] < keys[second];
+    };
+    using IndexHeap = Heap<size_t, decltype(compare)>;
+    IndexHeap heap(compare, [&indices](size_t element, size_t index) {
+        indices[element] = index;
+    });
+    std::multiset<int> expected;
+    for (size_t step = 0; step < 20000; ++step) {
+        const size_t action = random() % 4;
+        if (expected.empty() || action < 2) {
+            keys.push_back(static_cast<int>(random() % 1000));
+            indices.push_back(0);
+            heap.push(keys.size() - 1);
+            expected.insert(keys.back());
+        } else if (action == 2) {
+            CHECK(keys[heap.top()] == *expected.begin());
+            expected.erase(expected.begin());
+            heap.pop();
+        } else {
+            //        observer'.
+            size_t element = random() % keys.size();
+            while (indices[element] == IndexHeap::kNullIndex) {
+                element = (element + 1) % keys.size();
+            }
+            CHECK(indices[element] < heap.size());
+            heap.erase(indices[element]);
+            CHECK(indices[element] == IndexHeap::kNullIndex);
+            expected.erase(expected.find(keys[element]));
+        }
+        CHECK(heap.size() == expected.size());
+    }
+}
+
+TEST(HeapWorksWithoutObserver) {
+    DefaultHeap heap;
+    for (int value : { 5, 1, 4, 2, 3 }) {
+        heap.push(value);
+    }
+    heap.erase(heap.size() - 1);
+    std::vector<int> popped;
+    while (!heap.empty()) {
+        popped.push_back(heap.top());
+        heap.pop();
+    }
+    CHECK(popped.size() == 4);
+    CHECK(std::is_sorted(popped.begin(), popped.end()));
+}
+
+TEST(OutOfRangeTenantLeavesManagerUsable) {
+    MemoryManager memory(100);
+    CHECK_THROWS(memory.Allocate(10, TenantQuotas::kMaxTenants));
+    CHECK_THROWS(memory.AllocateNear(10, 50, TenantQuotas::kMaxTenants));
+    CHECK_THROWS(memory.AllocateOrWait(10, [](MemoryManager::Iterator) {},
+        TenantQuotas::kMaxTenants));
+    CHECK(memory.WaitingCount() == 0);
+    CHECK(memory.Allocate(100) != memory.end());
+}
+
+
+TEST(CancelWaitServesRequestsBehindFifoHead) {
+    MemoryManager memory(10);
+    memory.Allocate(8);
+    size_t served = 0;
+    const MemoryManager::WaitTicket head = memory.AllocateOrWait(8,
+        [&](MemoryManager::Iterator) {
+            served += 8;
+        });
+    memory.AllocateOrWait(2, [&](MemoryManager::Iterator) {
+        served += 2;
+    });
+    CHECK(served == 0);
+    CHECK(memory.CancelWait(head));
+    CHECK(!memory.CancelWait(head));
+    CHECK(served == 2);
+    CHECK(memory.WaitingCount() == 0);
+}
+
+/*
+*      ,     
+*    ;     .
+*/
+/*
+*  1    ,       .
+*      ,     
+*   ,      
+*   .
+*/
+TEST(QuotaBlockedRequestDoesNotBlockQueue) {
+    for (WaitingQueuePolicy policy : { WaitingQueuePolicy::kFifo,
+        WaitingQueuePolicy::kSmallestFirst, WaitingQueuePolicy::kFirstFit }) {
+        MemoryManager memory(100);
+        memory.SetWaitingQueuePolicy(policy);
+        TenantLimits limits;
+        limits.hard_quota = 10;
+        memory.SetTenantLimits(1, limits);
+        MemoryManager::Iterator quota_holder = memory.Allocate(10, 1);
+        MemoryManager::Iterator other = memory.Allocate(90);
+        std::vector<size_t> served;
+        memory.AllocateOrWait(5, [&](MemoryManager::Iterator) {
+            served.push_back(5);
+        }, 1);
+        memory.AllocateOrWait(20, [&](MemoryManager::Iterator) {
+            served.push_back(20);
+        });
+        CHECK(served.empty());
+        memory.Free(other);
+        CHECK(served == std::vector<size_t>({ 20 }));
+        //    ,        .
+        memory.AllocateOrWait(30, [&](MemoryManager::Iterator) {
+            served.push_back(30);
+        });
+        CHECK(served == std::vector<size_t>({ 20, 30 }));
+        CHECK(memory.GetTenantUsage(1).rejected_allocations == 1);
+        memory.Free(quota_holder);
+        CHECK(served == std::vector<size_t>({ 20, 30, 5 }));
+        CHECK(memory.WaitingCount() == 0);
+    }
+}
+
+TEST(QueryHandleMapCompactsAroundLongLivedEntry) {
+    std::mt19937 random(7);
+    QueryHandleMap handles;
+    handles.Insert(0, 42);
+    std::vector<size_t> live;
+    for (size_t query_index = 1; query_index < 50000; ++query_index) {
+        handles.Insert(query_index, static_cast<QueryHandleMap::Handle>(query_index));
+        live.push_back(query_index);
+        if (live.size() == 1000) {
+            std::shuffle(live.begin(), live.end(), random);
+            for (size_t extracted : live) {
+                QueryHandleMap::Handle handle = 0;
+                CHECK(handles.Extract(extracted, &handle));
+                CHECK(handle == static_cast<QueryHandleMap::Handle>(extracted));
+            }
+            live.clear();
+        }
+    }
+    QueryHandleMap::Handle handle = 0;
+    CHECK(!handles.Extract(1, &handle));
+    CHECK(handles.Extract(0, &handle));
+    CHECK(handle == 42);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+*        . TEST(Name)
+*        , CHECK
+*  TestFailure   ,   . 
+*     main  test_main.cpp.
+*/
+
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+std::vector<TestCase>& RegisteredTests();
+
+//   trace'   ;   .
+const std::string& TestDataDirectory();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*function)()) {
+        RegisteredTests().push_back(TestCase{ name, function });
+    }
+};
+
+class TestFailure : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            throw TestFailure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + \
+                ": CHECK(" #condition ") failed"); \
+        } \
+    } while (false)
+
+#define CHECK_THROWS(expression) \
+    do { \
+        bool thrown = false; \
+        try { \
+            expression; \
+        } catch (const std::exception&) { \
+            thrown = true; \
+        } \
+        if (!thrown) { \
+            throw TestFailure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + \
+                ": " #expression " did not throw"); \
+        } \
+    } while (false)
@@ -0,0 +1,46 @@
+#include "test.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+std::vector<TestCase>& RegisteredTests() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+static std::string test_data_directory = "tests/data";
+
+const std::string& TestDataDirectory() {
+    return test_data_directory;
+}
+
+/*
+* : memory_manager_tests [DATA_DIR [NAME_SUBSTRING]]
+*    ( ,     NAME_SUBSTRING) 
+*  1,        .
+*/
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        test_data_directory = argv[1];
+    }
+    const std::string filter = argc > 2 ? argv[2] : "";
+    size_t passed = 0;
+    size_t failed = 0;
+    for (const TestCase& test : RegisteredTests()) {
+        if (std::string(test.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        try {
+            test.function();
+            std::cout << "[  OK  ] " << test.name << "\n";
+            ++passed;
+        } catch (const std::exception& error) {
+            std::cout << "[ FAIL ] " << test.name << ": " << error.what() << "\n";
+            ++failed;
+        }
+    }
+    std::cout << passed << " passed, " << failed << " failed\n";
+    return failed == 0 ? 0 : 1;
+}
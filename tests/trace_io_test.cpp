@@ -0,0 +1,720 @@
+#include "memory_manager/async_io.h"
+#include "memory_manager/daemon.h"
+#include "memory_manager/query.h"
+#include "memory_manager/replay.h"
+#include "memory_manager/thread_pool.h"
+#include "memory_manager/trace_io.h"
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw TestFailure("Cannot open " + path);
+    }
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//    :   -1  .
+std::vector<long long> ParseResponses(const std::string& output) {
+    std::istringstream stream(output);
+    std::vector<long long> responses;
+    long long response;
+    while (stream >> response) {
+        responses.push_back(response);
+    }
+    return responses;
+}
+
+std::vector<long long> ResponseValues(const std::vector<MemoryManagerAllocationResponse>& responses) {
+    std::vector<long long> values;
+    for (const MemoryManagerAllocationResponse& response : responses) {
+        values.push_back(response.success ? static_cast<long long>(response.position) : -1);
+    }
+    return values;
+}
+
+const char* const kGoldenTraces[] = { "example", "random_small_memory", "random_large_memory" };
+
+/*
+*   trace'  TestDataDirectory()    
+*  .
+*/
+TEST(ReplayMatchesOriginalOutput) {
+    for (const char* name : kGoldenTraces) {
+        const std::string path = TestDataDirectory() + "/" + name;
+        const std::vector<long long> expected = ParseResponses(ReadFile(path + ".expected"));
+        std::istringstream trace(ReadFile(path + ".txt"));
+        const size_t memory_size = ReadMemorySize(trace);
+        const std::vector<MemoryManagerQuery> queries = ReadMemoryManagerQueries(trace);
+        CHECK(ResponseValues(RunMemoryManager(memory_size, queries)) == expected);
+    }
+}
+
+TEST(QueriesKeepTheirAlternative) {
+    std::istringstream stream("3\n5:2 -1 7\n");
+    const std::vector<MemoryManagerQuery> queries = ReadMemoryManagerQueries(stream);
+    CHECK(queries.size() == 3);
+    CHECK(queries[0].GetType() == MemoryManagerQuery::Type::kAllocation);
+    CHECK(queries[0].AsAllocationQuery()->allocation_size == 5);
+    CHECK(queries[0].AsAllocationQuery()->tenant == 2);
+    CHECK(queries[0].AsFreeQuery() == nullptr);
+    CHECK(queries[1].GetType() == MemoryManagerQuery::Type::kFree);
+    CHECK(queries[1].AsFreeQuery()->allocation_query_index == 1);
+    CHECK(queries[1].AsAllocationQuery() == nullptr);
+    CHECK(queries[2].AsAllocationQuery()->tenant == kDefaultTenant);
+}
+
+TEST(FastInputReaderMatchesStream) {
+    std::mt19937 random(6);
+    std::string trace = "100000\n3000\n";
+    for (size_t query = 0; query < 3000; ++query) {
+        if (random() % 3 == 0) {
+            trace += "-" + std::to_string(1 + random() % (query + 1));
+        } else {
+            trace += std::to_string(1 + random() % 1000);
+            if (random() % 4 == 0) {
+                trace += ":" + std::to_string(random() % 8);
+            }
+        }
+        trace += random() % 2 == 0 ? "\n" : "  \t";
+    }
+    std::FILE* file = std::tmpfile();
+    CHECK(file != nullptr);
+    CHECK(std::fwrite(trace.data(), 1, trace.size(), file) == trace.size());
+    std::rewind(file);
+    //       .
+    FastInputReader reader(file, 100);
+    const size_t memory_size = ReadMemorySize(reader);
+    const std::vector<MemoryManagerQuery> queries = ReadMemoryManagerQueries(reader);
+    std::fclose(file);
+
+    std::istringstream stream(trace);
+    CHECK(memory_size == ReadMemorySize(stream));
+    const std::vector<MemoryManagerQuery> expected = ReadMemoryManagerQueries(stream);
+    CHECK(queries.size() == expected.size());
+    for (size_t query = 0; query < queries.size(); ++query) {
+        CHECK(queries[query].GetType() == expected[query].GetType());
+        if (const AllocationQuery* allocation_query = expected[query].AsAllocationQuery()) {
+            CHECK(queries[query].AsAllocationQuery()->allocation_size == allocation_query->allocation_size);
+            CHECK(queries[query].AsAllocationQuery()->tenant == allocation_query->tenant);
+        } else {
+            CHECK(queries[query].AsFreeQuery()->allocation_query_index ==
+                expected[query].AsFreeQuery()->allocation_query_index);
+        }
+    }
+}
+
+TEST(MappedTraceMatchesOriginalOutput) {
+    for (const char* name : kGoldenTraces) {
+        const std::string path = TestDataDirectory() + "/" + name;
+        const std::vector<long long> expected = ParseResponses(ReadFile(path + ".expected"));
+        MappedFile trace(path + ".txt");
+        FastInputReader reader(trace.begin(), trace.end());
+        const size_t memory_size = ReadMemorySize(reader);
+        const std::vector<MemoryManagerQuery> queries = ReadMemoryManagerQueries(reader);
+        CHECK(ResponseValues(RunMemoryManager(memory_size, queries)) == expected);
+    }
+    CHECK_THROWS(MappedFile(TestDataDirectory() + "/missing.txt"));
+}
+
+TEST(StreamingReplayMatchesOriginalOutput) {
+    for (const char* name : kGoldenTraces) {
+        const std::string path = TestDataDirectory() + "/" + name;
+        const std::vector<long long> expected = ParseResponses(ReadFile(path + ".expected"));
+        const std::string trace = ReadFile(path + ".txt");
+        FastInputReader input_reader(trace.data(), trace.data() + trace.size());
+        TextTraceReader trace_reader(input_reader);
+        ReplayOptions options;
+        options.stream = true;
+        std::ostringstream output;
+        ReplayTrace(trace_reader, output, options);
+        CHECK(ParseResponses(output.str()) == expected);
+    }
+}
+
+std::vector<MemoryManagerQuery> MakeTraceQueries(bool with_tenants, bool with_arenas) {
+    std::mt19937 random(7);
+    std::vector<MemoryManagerQuery> queries;
+    for (size_t current_query = 0; current_query < 2000; ++current_query) {
+        if (current_query > 0 && random() % 3 == 0) {
+            queries.emplace_back(FreeQuery{ static_cast<int>(1 + random() % current_query) });
+            continue;
+        }
+        AllocationQuery allocation_query{ 1 + random() % (random() % 2 == 0 ? 100 : 1000000) };
+        if (with_tenants) {
+            allocation_query.tenant = random() % 4 == 0 ? TenantQuotas::kMaxTenants - 1 : random() % 5;
+        }
+        if (with_arenas) {
+            allocation_query.arena = random() % 4 == 0 ? UINT32_MAX : random() % 3;
+        }
+        queries.emplace_back(allocation_query);
+    }
+    return queries;
+}
+
+bool SameQueries(const std::vector<MemoryManagerQuery>& first,
+    const std::vector<MemoryManagerQuery>& second) {
+    if (first.size() != second.size()) {
+        return false;
+    }
+    for (size_t query = 0; query < first.size(); ++query) {
+        const AllocationQuery* first_allocation = first[query].AsAllocationQuery();
+        const AllocationQuery* second_allocation = second[query].AsAllocationQuery();
+        if ((first_allocation == nullptr) != (second_allocation == nullptr)) {
+            return false;
+        }
+        if (first_allocation != nullptr) {
+            if (first_allocation->allocation_size != second_allocation->allocation_size ||
+                first_allocation->tenant != second_allocation->tenant ||
+                first_allocation->arena != second_allocation->arena) {
+                return false;
+            }
+        } else if (first[query].AsFreeQuery()->allocation_query_index !=
+                   second[query].AsFreeQuery()->allocation_query_index) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(BinaryTraceRoundTrip) {
+    for (bool with_tenants : { false, true }) {
+        for (bool with_arenas : { false, true }) {
+            const std::vector<MemoryManagerQuery> queries = MakeTraceQueries(with_tenants, with_arenas);
+            std::ostringstream output;
+            WriteBinaryTrace(12345, queries, output);
+            const std::string trace = output.str();
+            CHECK(IsBinaryTrace(trace.data(), trace.data() + trace.size()));
+
+            BinaryTraceReader mapped_reader(trace.data(), trace.data() + trace.size());
+            CHECK(mapped_reader.MemorySize() == 12345);
+            CHECK(SameQueries(ReadTraceQueries(mapped_reader), queries));
+
+            std::FILE* file = fmemopen(const_cast<char*>(trace.data()), trace.size(), "rb");
+            FastInputReader input_reader(file, 64);
+            CHECK(input_reader.StartsWith(kBinaryTraceMagic, sizeof(kBinaryTraceMagic)));
+            BinaryTraceReader stream_reader(input_reader);
+            CHECK(stream_reader.MemorySize() == 12345);
+            CHECK(SameQueries(ReadTraceQueries(stream_reader), queries));
+            std::fclose(file);
+        }
+    }
+}
+
+TEST(TextTraceRoundTrip) {
+    const std::vector<MemoryManagerQuery> queries = MakeTraceQueries(true, true);
+    std::ostringstream output;
+    WriteTextTrace(54321, queries, output);
+    const std::string trace = output.str();
+    CHECK(!IsBinaryTrace(trace.data(), trace.data() + trace.size()));
+
+    FastInputReader input_reader(trace.data(), trace.data() + trace.size());
+    TextTraceReader trace_reader(input_reader);
+    CHECK(trace_reader.MemorySize() == 54321);
+    CHECK(SameQueries(ReadTraceQueries(trace_reader), queries));
+
+    std::istringstream input(trace);
+    CHECK(ReadMemorySize(input) == 54321);
+    CHECK(SameQueries(ReadMemoryManagerQueries(input), queries));
+}
+
+TEST(BinaryAndTextTracesReplayAlike) {
+    const std::vector<MemoryManagerQuery> queries = MakeTraceQueries(false, false);
+    std::ostringstream binary;
+    WriteBinaryTrace(100000, queries, binary);
+    std::ostringstream text;
+    WriteTextTrace(100000, queries, text);
+    const std::string binary_trace = binary.str();
+    const std::string text_trace = text.str();
+
+    std::ostringstream binary_output;
+    FastInputReader binary_reader(binary_trace.data(), binary_trace.data() + binary_trace.size());
+    ReplayTraceStream(binary_reader, binary_output, ReplayOptions());
+    std::ostringstream text_output;
+    FastInputReader text_reader(text_trace.data(), text_trace.data() + text_trace.size());
+    ReplayTraceStream(text_reader, text_output, ReplayOptions());
+    CHECK(binary_output.str() == text_output.str());
+    CHECK(binary_output.str().size() > 1);
+}
+
+TEST(MalformedBinaryTracesAreRejected) {
+    const std::vector<MemoryManagerQuery> queries = MakeTraceQueries(true, false);
+    std::ostringstream output;
+    WriteBinaryTrace(100, queries, output);
+    const std::string trace = output.str();
+    BinaryTraceReader truncated(trace.data(), trace.data() + trace.size() - 1);
+    CHECK_THROWS(ReadTraceQueries(truncated));
+
+    std::string header(kBinaryTraceMagic, sizeof(kBinaryTraceMagic));
+    header.push_back(static_cast<char>(kBinaryTraceVersion));
+    header.push_back(static_cast<char>(kBinaryTraceHasTenants));
+    std::string bad_tenant = header;
+    WriteVarint(100, &bad_tenant);
+    WriteVarint(1, &bad_tenant);
+    WriteVarint(10, &bad_tenant);
+    WriteVarint(TenantQuotas::kMaxTenants, &bad_tenant);
+    BinaryTraceReader tenant_reader(bad_tenant.data(), bad_tenant.data() + bad_tenant.size());
+    CHECK_THROWS(ReadTraceQueries(tenant_reader));
+
+    std::string bad_version = header;
+    bad_version[sizeof(kBinaryTraceMagic)] = static_cast<char>(kBinaryTraceVersion + 1);
+    CHECK_THROWS(BinaryTraceReader(bad_version.data(), bad_version.data() + bad_version.size()));
+}
+
+TEST(FastOutputWriterMatchesStream) {
+    std::mt19937_64 random(8);
+    std::ostringstream output;
+    std::ostringstream expected;
+    {
+        //    ,     .
+        FastOutputWriter writer(output, 40);
+        for (long long value : { std::numeric_limits<long long>::min(),
+                 std::numeric_limits<long long>::max(), 0LL, -1LL }) {
+            writer.WriteInteger(value);
+            writer.WriteChar(' ');
+            expected << value << ' ';
+        }
+        for (size_t number = 0; number < 10000; ++number) {
+            const long long value = static_cast<long long>(random()) >> (random() % 64);
+            writer.WriteInteger(value);
+            writer.WriteChar('\n');
+            expected << value << '\n';
+        }
+    }
+    CHECK(output.str() == expected.str());
+}
+
+TEST(ResponsesAreWrittenToTheGivenStream) {
+    for (const char* name : kGoldenTraces) {
+        const std::string path = TestDataDirectory() + "/" + name;
+        std::istringstream trace(ReadFile(path + ".txt"));
+        const size_t memory_size = ReadMemorySize(trace);
+        const std::vector<MemoryManagerQuery> queries = ReadMemoryManagerQueries(trace);
+        std::ostringstream output;
+        OutputMemoryManagerResponses(RunMemoryManager(memory_size, queries), output);
+        CHECK(output.str() == ReadFile(path + ".expected"));
+    }
+}
+
+std::string ReplayText(const std::string& trace, const ReplayOptions& options) {
+    FastInputReader input_reader(trace.data(), trace.data() + trace.size());
+    TextTraceReader trace_reader(input_reader);
+    std::ostringstream output;
+    ReplayTrace(trace_reader, output, options);
+    return output.str();
+}
+
+TEST(PipelinedReplayMatchesOriginalOutput) {
+    ReplayOptions options;
+    options.pipeline = true;
+    for (const char* name : kGoldenTraces) {
+        const std::string path = TestDataDirectory() + "/" + name;
+        CHECK(ReplayText(ReadFile(path + ".txt"), options) == ReadFile(path + ".expected"));
+    }
+    // Trace    .
+    std::vector<MemoryManagerQuery> queries;
+    for (size_t round = 0; round < 10; ++round) {
+        const std::vector<MemoryManagerQuery> part = MakeTraceQueries(false, false);
+        queries.insert(queries.end(), part.begin(), part.end());
+    }
+    std::ostringstream text;
+    WriteTextTrace(1000000, queries, text);
+    CHECK(ReplayText(text.str(), options) == ReplayText(text.str(), ReplayOptions()));
+}
+
+//   ,    .
+std::filesystem::path MakeTemporaryDirectory(const std::string& name) {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() /
+        ("memory_manager_" + name + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+TEST(WorkStealingThreadPoolRunsEveryTask) {
+    std::atomic<size_t> done(0);
+    WorkStealingThreadPool pool(4);
+    for (size_t task = 0; task < 1000; ++task) {
+        pool.Submit([&done] {
+            ++done;
+        });
+    }
+    pool.Wait();
+    CHECK(done == 1000);
+}
+
+TEST(BatchReplayWritesOutputPerTrace) {
+    namespace fs = std::filesystem;
+    const fs::path traces = MakeTemporaryDirectory("batch_traces");
+    const fs::path outputs = MakeTemporaryDirectory("batch_outputs");
+    for (const char* name : kGoldenTraces) {
+        fs::copy_file(TestDataDirectory() + "/" + name + ".txt", traces / (std::string(name) + ".txt"));
+    }
+    ReplayOptions options;
+    options.batch_path = traces.string();
+    options.output_dir = outputs.string();
+    options.threads_count = 2;
+    CHECK(RunBatchReplay(options));
+    for (const char* name : kGoldenTraces) {
+        CHECK(ReadFile((outputs / (std::string(name) + ".txt.out")).string()) ==
+            ReadFile(TestDataDirectory() + "/" + name + ".expected"));
+    }
+    std::istringstream timings(ReadFile((outputs / "timings.tsv").string()));
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(timings, line)) {
+        CHECK(lines == 0 || line.substr(line.size() - 3) == "\tok");
+        ++lines;
+    }
+    CHECK(lines == 1 + std::size(kGoldenTraces));
+    fs::remove_all(traces);
+    fs::remove_all(outputs);
+}
+
+TEST(BatchReplayKeepsDuplicateNamesApart) {
+    namespace fs = std::filesystem;
+    const fs::path traces = MakeTemporaryDirectory("batch_duplicates");
+    const fs::path outputs = MakeTemporaryDirectory("batch_duplicate_outputs");
+    //  trace'    trace.txt     , 
+    //       .
+    std::ofstream manifest(traces / "manifest");
+    for (size_t copy = 0; copy < std::size(kGoldenTraces); ++copy) {
+        fs::create_directories(traces / std::to_string(copy));
+        const fs::path path = traces / std::to_string(copy) / "trace.txt";
+        fs::copy_file(TestDataDirectory() + "/" + kGoldenTraces[copy] + ".txt", path);
+        manifest << path.string() << "\n";
+    }
+    fs::copy_file(TestDataDirectory() + "/" + kGoldenTraces[0] + ".txt", traces / "trace.txt.2");
+    manifest << (traces / "trace.txt.2").string() << "\n";
+    manifest.close();
+    ReplayOptions options;
+    options.batch_path = (traces / "manifest").string();
+    options.output_dir = outputs.string();
+    CHECK(RunBatchReplay(options));
+    for (size_t copy = 0; copy < std::size(kGoldenTraces); ++copy) {
+        const std::string name = "trace.txt" +
+            (copy == 0 ? std::string() : "." + std::to_string(copy + 1)) + ".out";
+        CHECK(ReadFile((outputs / name).string()) ==
+            ReadFile(TestDataDirectory() + "/" + kGoldenTraces[copy] + ".expected"));
+    }
+    CHECK(ReadFile((outputs / "trace.txt.2.2.out").string()) ==
+        ReadFile(TestDataDirectory() + "/" + kGoldenTraces[0] + ".expected"));
+    fs::remove_all(traces);
+    fs::remove_all(outputs);
+}
+
+TEST(ArenasAreReplayedIndependently) {
+    //  1  2 -    10 .
+    ReplayOptions options;
+    CHECK(ReplayText("10 5\n10@1 10@2 5@1 -1 5:3@1\n", options) == "1\n1\n-1\n1\n\n");
+    options.stream = true;
+    CHECK_THROWS(ReplayText("10 1\n10@1\n", options));
+}
+
+TEST(ArenaReplayDoesNotDependOnThreads) {
+    std::vector<MemoryManagerQuery> queries;
+    for (size_t round = 0; round < 5; ++round) {
+        const std::vector<MemoryManagerQuery> part = MakeTraceQueries(false, true);
+        queries.insert(queries.end(), part.begin(), part.end());
+    }
+    std::ostringstream text;
+    WriteTextTrace(1000000, queries, text);
+    ReplayOptions options;
+    options.threads_count = 1;
+    const std::string single_thread = ReplayText(text.str(), options);
+    options.threads_count = 4;
+    CHECK(ReplayText(text.str(), options) == single_thread);
+    CHECK(single_thread.size() > 1);
+}
+
+/*
+*     io_uring (   read/write,  
+*     )   ,    
+*  ,     ,    .
+*/
+TEST(AsyncFileIoMatchesPlainReplay) {
+    namespace fs = std::filesystem;
+    std::vector<MemoryManagerQuery> queries;
+    for (size_t round = 0; round < 5; ++round) {
+        const std::vector<MemoryManagerQuery> part = MakeTraceQueries(true, false);
+        queries.insert(queries.end(), part.begin(), part.end());
+    }
+    std::ostringstream text;
+    WriteTextTrace(1000000, queries, text);
+    const fs::path directory = MakeTemporaryDirectory("async_io");
+    const fs::path trace_path = directory / "trace.txt";
+    const fs::path output_path = directory / "trace.out";
+    std::ofstream(trace_path, std::ios::binary) << text.str();
+
+    const int input_fd = ::open(trace_path.c_str(), O_RDONLY);
+    const int output_fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CHECK(input_fd >= 0 && output_fd >= 0);
+    {
+        AsyncFileReader input(input_fd, 4096, 4);
+        FastInputReader input_reader(&input, 1024);
+        TextTraceReader trace_reader(input_reader);
+        AsyncFileWriter output_buffer(output_fd, 4096, 4);
+        std::ostream output(&output_buffer);
+        ReplayTrace(trace_reader, output, ReplayOptions());
+        output_buffer.Finish();
+    }
+    ::close(input_fd);
+    ::close(output_fd);
+    CHECK(ReadFile(output_path.string()) == ReplayText(text.str(), ReplayOptions()));
+    fs::remove_all(directory);
+}
+
+DaemonRequest MakeDaemonRequest(DaemonRequestType type, uint64_t value) {
+    DaemonRequest request;
+    std::memset(&request, 0, sizeof(request));
+    request.type = type;
+    request.tenant = kDefaultTenant;
+    request.value = value;
+    return request;
+}
+
+//   ,       .
+template <class Client>
+std::unique_ptr<Client> ConnectToDaemon(const std::string& name) {
+    for (size_t attempt = 0;; ++attempt) {
+        try {
+            return std::make_unique<Client>(name);
+        } catch (const std::runtime_error&) {
+            if (attempt == 1000) {
+                throw;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+TEST(DaemonServesRequestsOverSocket) {
+    const std::filesystem::path directory = MakeTemporaryDirectory("daemon");
+    const std::string socket_path = (directory / "socket").string();
+    AllocatorDaemon daemon(100, ReplayOptions());
+    std::thread server([&] {
+        daemon.Serve(socket_path);
+    });
+    std::vector<DaemonResponse> responses;
+    std::exception_ptr error;
+    try {
+        std::unique_ptr<DaemonClient> client = ConnectToDaemon<DaemonClient>(socket_path);
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kAllocate, 10)));
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kAllocate, 95)));
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kStats, 0)));
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kFree, 1)));
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kFree, 1)));
+        responses.push_back(client->Call(MakeDaemonRequest(DaemonRequestType::kStats, 0)));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    //     ,    
+    // ;    ,   .
+    daemon_stop_requested = 1;
+    try {
+        DaemonClient wake(socket_path);
+    } catch (const std::runtime_error&) {
+    }
+    server.join();
+    daemon_stop_requested = 0;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    CHECK(responses[0].status == DaemonStatus::kOk && responses[0].value == 1);
+    CHECK(responses[1].status == DaemonStatus::kFailed);
+    CHECK(responses[2].value == 10 && responses[2].extra == 1);
+    CHECK(responses[3].status == DaemonStatus::kOk);
+    CHECK(responses[4].status == DaemonStatus::kInvalidRequest);
+    CHECK(responses[5].value == 0 && responses[5].extra == 0);
+    CHECK(!std::filesystem::exists(socket_path));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(AllocatorServiceAnswersRequests) {
+    AllocatorService service(100, ReplayOptions());
+    DaemonResponse response = service.Execute(MakeDaemonRequest(DaemonRequestType::kAllocate, 0));
+    CHECK(response.status == DaemonStatus::kFailed);
+    response = service.Execute(MakeDaemonRequest(DaemonRequestType::kAllocate, 30));
+    CHECK(response.status == DaemonStatus::kOk && response.value == 1);
+    response = service.Execute(MakeDaemonRequest(DaemonRequestType::kFree, 2));
+    CHECK(response.status == DaemonStatus::kInvalidRequest);
+    response = service.Execute(MakeDaemonRequest(static_cast<DaemonRequestType>(9), 0));
+    CHECK(response.status == DaemonStatus::kInvalidRequest);
+    DaemonRequest foreign_tenant = MakeDaemonRequest(DaemonRequestType::kAllocate, 10);
+    foreign_tenant.tenant = TenantQuotas::kMaxTenants;
+    CHECK(service.Execute(foreign_tenant).status == DaemonStatus::kInvalidRequest);
+    response = service.Execute(MakeDaemonRequest(DaemonRequestType::kStats, 0));
+    CHECK(response.value == 30 && response.extra == 1);
+}
+
+TEST(SharedMemoryDaemonServesClients) {
+    const std::string name = "/memory_manager_test_" + std::to_string(::getpid());
+    SharedMemoryAllocatorServer server(1000, ReplayOptions());
+    std::thread server_thread([&] {
+        server.Serve(name);
+    });
+    //       ,    .
+    const std::string segment_path = "/dev/shm" + name;
+    std::error_code size_error;
+    while (std::filesystem::file_size(segment_path, size_error) != sizeof(SharedMemorySegment)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::vector<uint64_t> positions;
+    DaemonResponse stats;
+    std::exception_ptr error;
+    try {
+        std::unique_ptr<SharedMemoryClient> first = ConnectToDaemon<SharedMemoryClient>(name);
+        SharedMemoryClient second(name);
+        //  ,     .
+        for (size_t call = 0; call < 2 * kSharedMemoryRingCapacity; ++call) {
+            SharedMemoryClient& client = call % 2 == 0 ? *first : second;
+            const DaemonResponse response = client.Call(MakeDaemonRequest(DaemonRequestType::kAllocate, 1));
+            if (response.status == DaemonStatus::kOk) {
+                positions.push_back(response.value);
+                client.Call(MakeDaemonRequest(DaemonRequestType::kFree, response.value));
+            }
+        }
+        stats = second.Call(MakeDaemonRequest(DaemonRequestType::kStats, 0));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    daemon_stop_requested = 1;
+    server_thread.join();
+    daemon_stop_requested = 0;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    CHECK(positions == std::vector<uint64_t>(2 * kSharedMemoryRingCapacity, 1));
+    CHECK(stats.value == 0 && stats.extra == 0);
+    CHECK(!std::filesystem::exists(segment_path));
+}
+
+TEST(SharedMemoryDaemonSurvivesRogueRequestTail) {
+    const std::string name = "/memory_manager_rogue_" + std::to_string(::getpid());
+    SharedMemoryAllocatorServer server(1000, ReplayOptions());
+    std::thread server_thread([&] {
+        server.Serve(name);
+    });
+    const std::string segment_path = "/dev/shm" + name;
+    std::error_code size_error;
+    while (std::filesystem::file_size(segment_path, size_error) != sizeof(SharedMemorySegment)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    DaemonResponse allocated;
+    DaemonResponse stats;
+    std::exception_ptr error;
+    try {
+        // ,   ,  request_tail  .
+        std::unique_ptr<SharedMemoryClient> first = ConnectToDaemon<SharedMemoryClient>(name);
+        first.reset();
+        SharedMemoryMapping rogue(name, false);
+        SharedMemoryClientSlot& slot = rogue->slots[0];
+        uint32_t expected = 0;
+        if (!slot.claimed.compare_exchange_strong(expected, 1)) {
+            throw std::runtime_error("Slot 0 is busy");
+        }
+        slot.request_tail.store(uint64_t(1) << 40);
+        SharedMemoryClient honest(name);
+        honest.Call(MakeDaemonRequest(DaemonRequestType::kStats, 0));
+        //  request_tail -  :     .
+        slot.request_tail.store(0);
+        while (slot.response_tail.load() != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        slot.claimed.store(0);
+        SharedMemoryClient next_owner(name);
+        allocated = next_owner.Call(MakeDaemonRequest(DaemonRequestType::kAllocate, 10));
+        next_owner.Call(MakeDaemonRequest(DaemonRequestType::kFree, allocated.value));
+        stats = honest.Call(MakeDaemonRequest(DaemonRequestType::kStats, 0));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    daemon_stop_requested = 1;
+    server_thread.join();
+    daemon_stop_requested = 0;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    CHECK(allocated.status == DaemonStatus::kOk);
+    CHECK(stats.value == 0 && stats.extra == 0);
+}
+
+TEST(MissingTextHeaderIsRejected) {
+    const std::string empty;
+    FastInputReader empty_reader(empty.data(), empty.data());
+    CHECK_THROWS(TextTraceReader trace_reader(empty_reader));
+    const std::string memory_only = "100\n";
+    FastInputReader memory_only_reader(memory_only.data(), memory_only.data() + memory_only.size());
+    CHECK_THROWS(TextTraceReader trace_reader(memory_only_reader));
+}
+
+TEST(TraceFromFifoIsStreamed) {
+    namespace fs = std::filesystem;
+    const fs::path directory = MakeTemporaryDirectory("fifo");
+    const std::string fifo_path = (directory / "trace").string();
+    CHECK(::mkfifo(fifo_path.c_str(), 0600) == 0);
+    const std::string path = TestDataDirectory() + "/random_large_memory";
+    const std::string text_trace = ReadFile(path + ".txt");
+    std::istringstream text_input(text_trace);
+    const size_t memory_size = ReadMemorySize(text_input);
+    std::ostringstream binary_trace;
+    WriteBinaryTrace(memory_size, ReadMemoryManagerQueries(text_input), binary_trace);
+    //  trace     ,    stdin.
+    for (const std::string& trace : { text_trace, binary_trace.str() }) {
+        std::thread writer([&] {
+            std::ofstream(fifo_path, std::ios::binary) << trace;
+        });
+        std::ostringstream output;
+        std::exception_ptr error;
+        try {
+            ReplayTraceFile(fifo_path, output, ReplayOptions());
+        } catch (...) {
+            error = std::current_exception();
+        }
+        writer.join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        CHECK(output.str() == ReadFile(path + ".expected"));
+    }
+    fs::remove_all(directory);
+}
+
+TEST(BatchReplaysArenaTracesLikeSingleTraces) {
+    namespace fs = std::filesystem;
+    const fs::path traces = MakeTemporaryDirectory("batch_arena_traces");
+    const fs::path outputs = MakeTemporaryDirectory("batch_arena_outputs");
+    std::ostringstream text;
+    WriteTextTrace(1000000, MakeTraceQueries(false, true), text);
+    std::ofstream(traces / "arenas.txt", std::ios::binary) << text.str();
+    ReplayOptions options;
+    options.batch_path = traces.string();
+    options.output_dir = outputs.string();
+    options.threads_count = 4;
+    CHECK(RunBatchReplay(options));
+    CHECK(ReadFile((outputs / "arenas.txt.out").string()) == ReplayText(text.str(), ReplayOptions()));
+    fs::remove_all(traces);
+    fs::remove_all(outputs);
+}